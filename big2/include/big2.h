@@ -22,12 +22,29 @@ namespace big2::detail {}
 #include <big2/asserts.h>
 #include <big2/app.h>
 #include <big2/app_extension_base.h>
+#include <big2/frame_scheduler.h>
+#include <big2/timer_service.h>
+#include <big2/main_thread_queue.h>
+#include <big2/thread_configuration.h>
+#include <big2/slot_map.h>
+#include <big2/hash.h>
+#include <big2/render_graph.h>
 #include <big2/default_quit_condition_app_extension.h>
+#include <big2/shader_hot_reloader.h>
+#include <big2/shader_hot_reload_app_extension.h>
 #include <big2/macros.h>
 #include <big2/void_ptr.h>
 #include <big2/glfw/glfw_utils.h>
 #include <big2/event_queue.h>
 #include <big2/bgfx/bgfx_utils.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/bgfx/bgfx_shader_cache.h>
+#include <big2/bgfx/bgfx_program_registry.h>
+#include <big2/bgfx/bgfx_pipeline_warmup.h>
+#include <big2/bgfx/bgfx_vertex_layout.h>
+#include <big2/bgfx/bgfx_render_state.h>
+#include <big2/bgfx/bgfx_uniform_registry.h>
 
 
 
@@ -8,10 +8,17 @@
 
 #include <gsl/gsl>
 #include <cstdint>
+#include <filesystem>
+#include <unordered_map>
 #include <vector>
 #include <chrono>
 #include <cmath>
 #include <big2/window.h>
+#include <big2/slot_map.h>
+#include <big2/frame_scheduler.h>
+#include <big2/timer_service.h>
+#include <big2/main_thread_queue.h>
+#include <big2/thread_configuration.h>
 #include <big2/glfw/glfw_initialization_scoped.h>
 #include <big2/bgfx/bgfx_view_scoped.h>
 #include <big2/bgfx/bgfx_frame_buffer_scoped.h>
@@ -22,6 +29,13 @@
 namespace big2 {
 class AppExtensionBase;
 
+/**
+ * @brief A stable reference to a window owned by the App.
+ * @details Unlike references to windows, handles stay valid when other windows are created or closed.
+ * A handle to a closed window resolves to nullptr.
+ */
+using WindowHandle = SlotHandle<Window>;
+
 template<class TExtension>
 concept AppExtensionDerived = std::is_base_of_v<AppExtensionBase, TExtension>;
 
@@ -34,17 +48,23 @@ class App final {
    Stop,
   };
 
-  explicit App(bgfx::RendererType::Enum renderer_type = bgfx::RendererType::Count, std::uint64_t capabilities = std::numeric_limits<std::uint64_t>::max());
+  /**
+   * @param transient_limits_file Keeps the transient buffer sizes between sessions, see BgfxInitializationScoped.
+   */
+  explicit App(bgfx::RendererType::Enum renderer_type = bgfx::RendererType::Count,
+               std::uint64_t capabilities = std::numeric_limits<std::uint64_t>::max(),
+               std::filesystem::path transient_limits_file = {});
 
   /**
    * @brief Creates an extension in the app.
    * @note You can only add extensions before running the app
    * @tparam TExtension A class that inherits AppExtensionBase
+   * @param args The arguments given to the constructor of the extension
    * @see AppExtensionBase
    */
-  template<AppExtensionDerived TExtension>
-  App &AddExtension() {
-   extensions_.push_back(std::make_unique<TExtension>());
+  template<AppExtensionDerived TExtension, typename... TArgs>
+  App &AddExtension(TArgs &&... args) {
+   extensions_.push_back(std::make_unique<TExtension>(std::forward<TArgs>(args)...));
 
    if (state_ == ActiveState::Run || state_ == ActiveState::Pause) {
     extensions_.back()->Initialize(this);
@@ -78,18 +98,46 @@ class App final {
 
   /**
    * @brief Creates a window with the given title and size.
+   * @details Renderers without a swap chain per window (see BgfxSupportsMultipleWindows()) only present to one window,
+   * which is the newest one. When it closes the back buffer moves to one of the remaining windows.
+   * @return A handle that can be resolved with GetWindow().
+   */
+  WindowHandle AddWindow(const std::string &title, glm::ivec2 size);
+
+  /**
+   * @brief Resolves a window handle.
+   * @return The window or nullptr if it was closed.
+   */
+  [[nodiscard]] Window *GetWindow(WindowHandle handle) { return windows_.Get(handle); }
+
+  /**
+   * @copydoc GetWindow(WindowHandle)
+   */
+  [[nodiscard]] const Window *GetWindow(WindowHandle handle) const { return windows_.Get(handle); }
+
+  /**
+   * @brief Finds the handle of an app window from its GLFW window in constant time.
+   * @return The handle or an invalid handle if the window isn't owned by the app.
+   */
+  [[nodiscard]] WindowHandle FindWindowHandle(GLFWwindow *window_handle) const;
+
+  /**
+   * @brief Finds an app window from its GLFW window in constant time.
+   * @return The window or nullptr if the window isn't owned by the app.
    */
-  Window &AddWindow(const std::string &title, glm::ivec2 size);
+  [[nodiscard]] Window *FindWindow(GLFWwindow *window_handle) { return GetWindow(FindWindowHandle(window_handle)); }
 
   /**
    * @brief Gets all created windows that are linked to the app.
+   * @details The windows are densely packed but their order changes when a window is closed.
+   * Don't keep references to them, use handles instead.
    */
-  [[nodiscard]] const std::vector<Window> &GetWindows() const { return windows_; }
+  [[nodiscard]] gsl::span<const Window> GetWindows() const { return windows_.GetValues(); }
 
   /**
    * @copydoc GetWindows() const
    */
-  [[nodiscard]] std::vector<Window> &GetWindows() { return windows_; }
+  [[nodiscard]] gsl::span<Window> GetWindows() { return windows_.GetValues(); }
 
   /**
    * @brief Gets the delta time for the current frame.
@@ -97,26 +145,90 @@ class App final {
    */
   [[nodiscard]] std::float_t GetDeltaTime() const { return delta_time_; }
 
+  /**
+   * @brief Gets the scheduler for deferrable work.
+   * @details Work queued here is executed after the mandatory phases of the frame
+   * for as long as it fits in the time remaining until the target frame time.
+   * @see SetTargetFrameTime()
+   */
+  [[nodiscard]] FrameScheduler &GetScheduler() { return scheduler_; }
+
+  /**
+   * @brief Sets the frame time that the deferrable work should try to fit in.
+   */
+  void SetTargetFrameTime(std::chrono::nanoseconds value) { target_frame_time_ = value; }
+  [[nodiscard]] std::chrono::nanoseconds GetTargetFrameTime() const { return target_frame_time_; }
+
+  /**
+   * @brief Gets the timer service which is dispatched once per frame before the extensions are updated.
+   */
+  [[nodiscard]] TimerService &GetTimers() { return timers_; }
+
+  /**
+   * @brief Gets the queue for commands that other threads need executed on the main thread.
+   * @details The queue is drained at the beginning of each frame before the events are polled,
+   * so window operations posted from worker threads will have their events processed in the same frame.
+   */
+  [[nodiscard]] MainThreadQueue &GetMainThreadQueue() { return *main_thread_queue_; }
+
+  /**
+   * @brief Sets the name, CPU pinning and scheduling priority for a kind of thread that BIG2 runs.
+   * @details The main and render thread configurations are applied when Run() is called.
+   * Worker threads apply their configuration when they start.
+   */
+  App &SetThreadConfiguration(ThreadRole role, ThreadConfiguration configuration);
+
+  /**
+   * @brief Reports the CPU time consumed by each configured thread.
+   * @see big2::GetThreadCpuTimes()
+   */
+  [[nodiscard]] std::vector<ThreadCpuTime> GetThreadCpuTimes() const { return big2::GetThreadCpuTimes(); }
+
+  /**
+   * @brief Makes the app sleep at the beginning of each frame until there are events, a timer is due or deferred work is queued.
+   * @details Use this for tools that only need to render when something changes.
+   */
+  void SetWaitForEvents(bool value) { wait_for_events_ = value; }
+  [[nodiscard]] bool GetWaitForEvents() const { return wait_for_events_; }
+
+  /**
+   * @brief Sets how long a window has to stay hidden or iconified before its frame buffer is released.
+   * @details Windows that aren't renderable are skipped in OnRender(). Their frame buffer is created again when they are shown.
+   * @see Window::UpdateFrameBuffer()
+   */
+  void SetWindowFrameBufferReleaseDelay(std::chrono::nanoseconds value) { window_frame_buffer_release_delay_ = value; }
+  [[nodiscard]] std::chrono::nanoseconds GetWindowFrameBufferReleaseDelay() const { return window_frame_buffer_release_delay_; }
+
  private:
   using time_point = std::chrono::steady_clock::time_point;
 
   void UpdateDeltaTime();
   void ProcessClosedWindows();
   void MandatoryBeginFrame();
+  void ExecuteDeferredWork();
+  void WaitForEvents();
 
   [[nodiscard]] ActiveState GetActiveState() const { return state_; }
   void SetActiveState(ActiveState value) { state_ = value; }
 
   std::vector<std::unique_ptr<AppExtensionBase> > extensions_;
-  std::vector<Window> windows_;
+  SlotMap<Window> windows_;
+  std::unordered_map<GLFWwindow *, WindowHandle> window_handles_;
+  FrameScheduler scheduler_;
+  TimerService timers_;
 
   time_point previous_frame_time_;
   std::float_t delta_time_ = 0.0f;
+  std::chrono::nanoseconds target_frame_time_ = std::chrono::nanoseconds(16'666'667);
+  std::chrono::nanoseconds window_frame_buffer_release_delay_ = Window::kDefaultFrameBufferReleaseDelay;
   ActiveState state_ = ActiveState::Unset;
   bool do_render_this_frame_ = true;
+  bool wait_for_events_ = false;
 
   std::unique_ptr<GlfwInitializationScoped> glfw_initialization_scoped_ = nullptr;
   std::unique_ptr<BgfxInitializationScoped> bgfx_initialization_scoped_ = nullptr;
+  // Destroyed before GLFW is terminated since posting wakes the main thread through GLFW
+  std::unique_ptr<MainThreadQueue> main_thread_queue_ = std::make_unique<MainThreadQueue>();
 };
 }
 #endif //BIG2_STACK_APP_H_
@@ -24,11 +24,12 @@ struct BgfxCallbackHandler final : public bgfx::CallbackI {
 
   void profilerEnd() override;
 
-  uint32_t cacheReadSize(uint64_t /*_id*/) override;
+  /// The cache callbacks are forwarded to BgfxShaderCache if there is an instance.
+  uint32_t cacheReadSize(uint64_t id) override;
 
-  bool cacheRead(uint64_t /*_id*/, void * /*_data*/, uint32_t /*_size*/) override;
+  bool cacheRead(uint64_t id, void *data, uint32_t size) override;
 
-  void cacheWrite(uint64_t /*_id*/, const void * /*_data*/, uint32_t /*_size*/) override;
+  void cacheWrite(uint64_t id, const void *data, uint32_t size) override;
 
   void screenShot(const char */*_filePath*/, uint32_t /*_width*/, uint32_t /*_height*/, uint32_t /*_pitch*/, const void */*_data*/, uint32_t /*_size*/, bool /*_yflip*/) override;
 
@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_DESTRUCTION_QUEUE_H_
+#define BIG2_STACK_BGFX_DESTRUCTION_QUEUE_H_
+
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <functional>
+#include <big2/bgfx/bgfx_handle_registry.h>
+
+namespace big2 {
+
+/**
+ * @brief Marks a point in the stream of submitted frames.
+ * @details A fence is signaled once enough frames were submitted after it for the GPU to be done with
+ * everything that was recorded before it. This is when memory passed to bgfx::makeRef() can be reused.
+ */
+struct FrameFence final {
+  std::uint32_t frame = 0;
+};
+
+/**
+ * @brief Submits the frame with bgfx::frame() and advances the destruction queue.
+ * @details Use this instead of bgfx::frame() so handles released with DestroyDeferred() are destroyed
+ * and fence callbacks are executed once their frames are done. App calls this for you.
+ * @return The frame number returned by bgfx::frame().
+ */
+std::uint32_t Frame(bool capture = false);
+
+/**
+ * @brief Gets how many frames were submitted through Frame().
+ */
+[[nodiscard]] std::uint32_t GetSubmittedFrameCount();
+
+/**
+ * @brief Sets after how many submitted frames released resources are destroyed and fences get signaled.
+ * @details The default is 2 since BGFX keeps one frame in flight on the render thread while the next one is recorded.
+ * 0 makes releases immediate.
+ */
+void SetDestructionLatency(std::uint32_t frames);
+[[nodiscard]] std::uint32_t GetDestructionLatency();
+
+/**
+ * @brief Creates a fence for the frame that is currently being recorded.
+ */
+[[nodiscard]] FrameFence InsertFrameFence();
+
+/**
+ * @brief Checks if the GPU is done with the frames up to the fence.
+ */
+[[nodiscard]] bool IsFrameFenceSignaled(FrameFence fence);
+
+/**
+ * @brief Executes the action on the main thread once the fence is signaled.
+ * @details The action is executed right away if the fence is already signaled or if BGFX isn't initialized
+ * through BgfxInitializationScoped.
+ */
+void ExecuteOnFrameFence(FrameFence fence, std::function<void()> action);
+
+/**
+ * @brief Destroys everything in the queue and executes all pending fence actions regardless of their frame.
+ * @details Called by BgfxInitializationScoped before BGFX is shut down.
+ */
+void FlushDestructionQueue();
+
+namespace detail {
+void DestroyDeferred(BgfxHandleType type, std::uint16_t index);
+}
+
+/**
+ * @brief Queues the handle to be destroyed once the frames that may still use it are done.
+ * @details Resources get destroyed in batches while submitting frames instead of in the middle of the frame.
+ * The handle is destroyed immediately if BGFX isn't initialized through BgfxInitializationScoped.
+ */
+template<typename BgfxType>
+void DestroyDeferred(BgfxType handle) {
+  static_assert(kBgfxHandleType<BgfxType> != BgfxHandleType::Count, "Not a bgfx handle that can be destroyed");
+  if (bgfx::isValid(handle)) {
+    detail::DestroyDeferred(kBgfxHandleType<BgfxType>, handle.idx);
+  }
+}
+
+}
+
+#endif //BIG2_STACK_BGFX_DESTRUCTION_QUEUE_H_
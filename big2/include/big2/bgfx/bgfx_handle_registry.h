@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_HANDLE_REGISTRY_H_
+#define BIG2_STACK_BGFX_HANDLE_REGISTRY_H_
+
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @ingroup(Macros)
+ * @brief When enabled BgfxScopedHandle tracks a generation for every bgfx handle to catch the use of stale handles.
+ * @details It is enabled by default in Debug builds. In other builds the tracking compiles away completely.
+ */
+#ifndef BIG2_CHECKED_HANDLES
+#define BIG2_CHECKED_HANDLES 0
+#endif
+
+namespace big2 {
+
+enum class BgfxHandleType : std::uint8_t {
+  DynamicIndexBuffer,
+  DynamicVertexBuffer,
+  FrameBuffer,
+  IndexBuffer,
+  IndirectBuffer,
+  OcclusionQuery,
+  Program,
+  Shader,
+  Texture,
+  Uniform,
+  VertexBuffer,
+  VertexLayout,
+  Count,
+};
+
+template<typename BgfxType>
+inline constexpr BgfxHandleType kBgfxHandleType = BgfxHandleType::Count;
+
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::DynamicIndexBufferHandle> = BgfxHandleType::DynamicIndexBuffer;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::DynamicVertexBufferHandle> = BgfxHandleType::DynamicVertexBuffer;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::FrameBufferHandle> = BgfxHandleType::FrameBuffer;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::IndexBufferHandle> = BgfxHandleType::IndexBuffer;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::IndirectBufferHandle> = BgfxHandleType::IndirectBuffer;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::OcclusionQueryHandle> = BgfxHandleType::OcclusionQuery;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::ProgramHandle> = BgfxHandleType::Program;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::ShaderHandle> = BgfxHandleType::Shader;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::TextureHandle> = BgfxHandleType::Texture;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::UniformHandle> = BgfxHandleType::Uniform;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::VertexBufferHandle> = BgfxHandleType::VertexBuffer;
+template<> inline constexpr BgfxHandleType kBgfxHandleType<bgfx::VertexLayoutHandle> = BgfxHandleType::VertexLayout;
+
+/**
+ * @brief Gets how many handles of a type are currently owned by BgfxScopedHandle instances.
+ * @details Only tracked when BIG2_CHECKED_HANDLES is enabled, otherwise this is always 0.
+ */
+[[nodiscard]] std::uint32_t GetLiveBgfxHandleCount(BgfxHandleType type);
+
+/**
+ * @private
+ * @brief The generation side table that BgfxScopedHandle uses in checked builds.
+ * @details Every bgfx index has a generation that is bumped when the destruction queue destroys it, so a handle
+ * that was taken before the destruction can be told apart from the handle that later reuses the same index.
+ */
+namespace detail {
+
+using BgfxHandleGeneration = std::uint16_t;
+
+BgfxHandleGeneration OnBgfxHandleAcquired(BgfxHandleType type, std::uint16_t index);
+void OnBgfxHandleReleased(BgfxHandleType type, std::uint16_t index);
+void OnBgfxHandleDestroyed(BgfxHandleType type, std::uint16_t index);
+[[nodiscard]] BgfxHandleGeneration GetBgfxHandleGeneration(BgfxHandleType type, std::uint16_t index);
+
+}
+
+}
+
+#endif //BIG2_STACK_BGFX_HANDLE_REGISTRY_H_
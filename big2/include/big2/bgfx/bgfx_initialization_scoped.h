@@ -9,6 +9,7 @@
 #include <bgfx/bgfx.h>
 #include <gsl/gsl>
 #include <glm/glm.hpp>
+#include <filesystem>
 
 struct GLFWwindow;
 
@@ -21,7 +22,14 @@ namespace big2 {
  */
 class BgfxInitializationScoped final {
   public:
-    BgfxInitializationScoped(bgfx::RendererType::Enum renderer_type = bgfx::RendererType::Count, std::uint64_t capabilities = std::numeric_limits<std::uint64_t>::max());
+    /**
+     * \param transient_limits_file Where the transient buffer high-water marks are kept between sessions.
+     * The marks of the last session size the transient buffers from the start and the file is updated on shutdown.
+     * Nothing is kept if it is empty.
+     */
+    BgfxInitializationScoped(bgfx::RendererType::Enum renderer_type = bgfx::RendererType::Count,
+                             std::uint64_t capabilities = std::numeric_limits<std::uint64_t>::max(),
+                             std::filesystem::path transient_limits_file = {});
 
     BgfxInitializationScoped(BgfxInitializationScoped && other);
 
@@ -36,14 +44,70 @@ class BgfxInitializationScoped final {
     static BgfxInitializationScoped *GetInstance() { return instance_; }
 
     /**
-     * \brief To be called after window is created if you initially created the instance in headless mode.
+     * \brief Shuts BGFX down and initializes it again with the window as its main window.
+     * \details All BGFX resources are destroyed by this. Prefer BindWindow() unless the renderer has to be recreated.
      */
     void ReInitialize(gsl::not_null<GLFWwindow *> window, glm::ivec2 size);
 
+    /**
+     * \brief Makes BGFX present its back buffer to the window without initializing it again.
+     * \details Used for renderers that can't create a swap chain per window (see BgfxSupportsMultipleWindows()).
+     * The native window is changed through bgfx::setPlatformData() and picked up by the following bgfx::reset(),
+     * so every resource survives. Only the bound window is presented to.
+     */
+    void BindWindow(gsl::not_null<GLFWwindow *> window, glm::ivec2 size);
+
+    /**
+     * \brief Forgets the bound window, to be called before the window is destroyed.
+     * \details BGFX keeps the old native window until another one is bound.
+     */
+    void UnbindWindow(gsl::not_null<GLFWwindow *> window);
+
+    [[nodiscard]] GLFWwindow *GetBoundWindow() const { return bound_window_; }
+
+    /**
+     * \brief Gets the limits BGFX was initialized with, including the sizes of the transient buffers.
+     */
+    [[nodiscard]] const bgfx::Init::Limits &GetLimits() const { return limits_; }
+
+    /**
+     * \brief Adds to the transient memory the current frame needs, including what didn't fit.
+     * \details Renderers report what they wanted to allocate so the per-frame high-water marks are known.
+     * Frames are told apart by GetSubmittedFrameCount(), so it needs frames to be submitted with big2::Frame().
+     * BGFX only takes the sizes of the transient buffers at initialization, so ReInitialize() and the next session
+     * (see the transient limits file) grow the limits to fit the high-water marks. Until then renderers have to fall
+     * back to other buffers.
+     */
+    void RecordTransientBufferUse(std::uint32_t vertex_bytes, std::uint32_t index_bytes);
+
+    /**
+     * \brief Gets the most transient vertex memory that was needed in a frame.
+     */
+    [[nodiscard]] std::uint32_t GetTransientVertexBufferHighWaterMark() const { return transient_vertex_high_water_mark_; }
+
+    /**
+     * \brief Gets the most transient index memory that was needed in a frame.
+     */
+    [[nodiscard]] std::uint32_t GetTransientIndexBufferHighWaterMark() const { return transient_index_high_water_mark_; }
+
   private:
+    void GrowTransientLimits();
+    void LoadTransientHighWaterMarks();
+    void SaveTransientHighWaterMarks() const;
+
     static BgfxInitializationScoped *instance_;
     bgfx::RendererType::Enum renderer_type_ = bgfx::RendererType::Count;
     std::uint64_t capabilities_ = std::numeric_limits<std::uint64_t>::max();
+    bgfx::PlatformData platform_data_ = {};
+    GLFWwindow *bound_window_ = nullptr;
+    bgfx::Init::Limits limits_ = bgfx::Init().limits;
+    std::filesystem::path transient_limits_file_;
+    bool has_new_high_water_marks_ = false;
+    std::uint32_t transient_use_frame_ = 0;
+    std::uint32_t transient_vertex_bytes_ = 0;
+    std::uint32_t transient_index_bytes_ = 0;
+    std::uint32_t transient_vertex_high_water_mark_ = 0;
+    std::uint32_t transient_index_high_water_mark_ = 0;
 };
 }
 
@@ -0,0 +1,107 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_PIPELINE_WARMUP_H_
+#define BIG2_STACK_BGFX_PIPELINE_WARMUP_H_
+
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include <big2/frame_scheduler.h>
+#include <big2/bgfx/bgfx_program_registry.h>
+#include <big2/bgfx/bgfx_render_target_pool.h>
+
+namespace big2 {
+
+/**
+ * @brief A combination of program, render state and vertex layout that a draw call used.
+ */
+struct PipelineDescription {
+  std::uint64_t vertex_shader = 0;
+  std::uint64_t fragment_shader = 0;
+  std::uint64_t state = 0;
+  bgfx::VertexLayout layout;
+};
+
+/**
+ * @brief A scoped singleton that records the pipelines used in a session and replays them on the next start.
+ * @details The first draw with a new combination of program, state and vertex layout makes the driver compile
+ * the pipeline, which can take long enough to drop frames. Draws report their pipelines with RecordPipeline()
+ * and the recorded ones are saved to the file when the warmup is destroyed.
+ * Enqueue() replays the pipelines of the last session through a FrameScheduler, one degenerate triangle
+ * per pipeline into a hidden 1x1 offscreen view, so they are spread over the frames of a loading phase.
+ * The driver compiles the pipelines on the render thread during bgfx::frame(), where the scheduler can't measure it,
+ * so a single work item per frame replays at most GetReplaysPerFrame() of them.
+ * The programs are kept alive for as long as the warmup exists, so they are already created when they are first used.
+ * Only programs of the program registry are recorded since their shader hashes stay the same between sessions.
+ * @note The replay target is RGBA8 with a D24S8 depth buffer. Renderers that bake the target formats into their
+ * pipelines (Vulkan, Metal, D3D12) may still compile again for targets with other formats.
+ */
+class BgfxPipelineWarmup final {
+ public:
+  explicit BgfxPipelineWarmup(std::filesystem::path file);
+  BgfxPipelineWarmup(BgfxPipelineWarmup &&) = delete;
+  BgfxPipelineWarmup &operator=(BgfxPipelineWarmup &&) = delete;
+  BgfxPipelineWarmup(const BgfxPipelineWarmup &) = delete;
+  BgfxPipelineWarmup &operator=(const BgfxPipelineWarmup &) = delete;
+  ~BgfxPipelineWarmup();
+
+  static BgfxPipelineWarmup *GetInstance() { return instance_; }
+
+  /**
+   * @brief Adds the pipeline to the ones saved for the next session. Recording the same pipeline again is cheap.
+   */
+  void Record(const ProgramReference &program, std::uint64_t state, const bgfx::VertexLayout &layout);
+
+  /**
+   * @brief Schedules the replay of the pipelines loaded from the file. Pipelines with unknown shaders are skipped.
+   * @details Call it after the shaders were registered. The work items stop doing anything once the warmup is destroyed.
+   * @return The number of scheduled pipelines.
+   */
+  std::size_t Enqueue(FrameScheduler &scheduler, FrameScheduler::Priority priority = FrameScheduler::Priority::High);
+
+  /**
+   * @brief Sets how many pipelines are replayed in one frame. Lower it if the warmup frames take too long.
+   */
+  void SetReplaysPerFrame(std::uint32_t count);
+  [[nodiscard]] std::uint32_t GetReplaysPerFrame() const { return replays_per_frame_; }
+
+  /**
+   * @brief Writes the recorded pipelines to the file. Called by the destructor if anything new was recorded.
+   */
+  void Save();
+
+  [[nodiscard]] std::size_t GetRecordedCount() const { return recorded_.size(); }
+  [[nodiscard]] std::size_t GetPendingCount() const;
+  [[nodiscard]] bool IsWarm() const { return GetPendingCount() == 0; }
+
+ private:
+  struct Replay;
+
+  [[nodiscard]] static std::uint64_t GetPipelineKey(const PipelineDescription &pipeline);
+  void Load();
+
+  static BgfxPipelineWarmup *instance_;
+
+  std::filesystem::path file_;
+  std::vector<PipelineDescription> recorded_;
+  std::unordered_set<std::uint64_t> recorded_keys_;
+  bool is_dirty_ = false;
+  std::uint32_t replays_per_frame_ = 4;
+  // Shared with the scheduled work items, which only hold a weak reference to it
+  std::shared_ptr<Replay> replay_;
+};
+
+/**
+ * @brief Records the pipeline in the active BgfxPipelineWarmup, does nothing if there is none.
+ */
+void RecordPipeline(const ProgramReference &program, std::uint64_t state, const bgfx::VertexLayout &layout);
+
+}
+
+#endif //BIG2_STACK_BGFX_PIPELINE_WARMUP_H_
@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_PROGRAM_REGISTRY_H_
+#define BIG2_STACK_BGFX_PROGRAM_REGISTRY_H_
+
+#include <bgfx/bgfx.h>
+#include <bgfx/embedded_shader.h>
+#include <gsl/gsl>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <big2/hash.h>
+
+namespace big2 {
+
+namespace detail {
+struct ProgramEntry;
+}
+
+/**
+ * @brief A counted reference to a program of the program registry.
+ * @details The program is created the first time Get() is called and destroyed when the last reference to it is gone.
+ * References have to be used from the main thread.
+ * @see GetProgram()
+ */
+class ProgramReference final {
+ public:
+  ProgramReference() = default;
+  ProgramReference(ProgramReference &&other) noexcept;
+  ProgramReference &operator=(ProgramReference &&other) noexcept;
+  ProgramReference(const ProgramReference &other);
+  ProgramReference &operator=(const ProgramReference &other);
+  ~ProgramReference();
+
+  /**
+   * @brief Gets the program handle, creating the program if this is its first use.
+   * @details Don't keep the handle around, the program may be replaced while it is referenced.
+   */
+  [[nodiscard]] bgfx::ProgramHandle Get() const;
+
+  explicit(false) operator bgfx::ProgramHandle() const { return Get(); }
+
+  [[nodiscard]] bool IsValid() const { return entry_ != nullptr; }
+
+  /**
+   * @return The shaders the program is made of, zero hashes for an invalid reference.
+   */
+  [[nodiscard]] HashedName GetVertexShader() const;
+  [[nodiscard]] HashedName GetFragmentShader() const;
+
+  /**
+   * @brief Drops the reference, destroying the program if it was the last one.
+   */
+  void Reset();
+
+ private:
+  friend ProgramReference GetProgram(HashedName vertex_shader, HashedName fragment_shader);
+
+  explicit ProgramReference(detail::ProgramEntry *entry);
+
+  detail::ProgramEntry *entry_ = nullptr;
+};
+
+/**
+ * @brief Makes the shaders of an embedded shader table available to GetProgram().
+ * @details The names are hashed once here, so looking shaders up doesn't scan the table like bgfx::createEmbeddedShader() does.
+ * Registering the same table again does nothing. The table has to stay alive for as long as the process runs.
+ * @param shaders A table that ends with BGFX_EMBEDDED_SHADER_END()
+ */
+void RegisterEmbeddedShaders(const bgfx::EmbeddedShader *shaders);
+
+/**
+ * @brief Gets a reference to the program made from two registered embedded shaders.
+ * @details Nothing is created until the program is used. All references to the same pair of shaders share one program.
+ * @code
+ * big2::RegisterEmbeddedShaders(kEmbeddedShaders);
+ * big2::ProgramReference program = big2::GetProgram("vs_basic", "fs_basic");
+ * bgfx::submit(view_id, program.Get());
+ * @endcode
+ */
+[[nodiscard]] ProgramReference GetProgram(HashedName vertex_shader, HashedName fragment_shader);
+
+/**
+ * @brief Checks if GetProgram() can create programs with the shader, i.e. it was registered, replaced or is a known variant.
+ */
+[[nodiscard]] bool IsShaderAvailable(HashedName shader);
+
+/**
+ * @brief Replaces the binary of a shader for the current renderer and recreates the programs that use it.
+ * @details Programs that were already created get a new handle which every ProgramReference picks up on its next Get().
+ * The old programs are destroyed through the deferred destruction queue. If the new program can't be created the old one is kept.
+ * Binaries of shader variants are also written to the BgfxShaderCache, if there is one.
+ * Call this between frames, i.e. before anything is submitted with the old programs.
+ * @return The number of programs that were recreated.
+ */
+std::size_t ReplaceShaderBinary(HashedName shader, std::vector<std::uint8_t> binary);
+
+/**
+ * @brief A set of variant keys, bit N stands for the Nth key of the shader's declaration.
+ */
+using ShaderVariantMask = std::uint32_t;
+
+/**
+ * @brief Describes the variant keys of a shader.
+ * @details add_shaders_directory() generates these from a <shader>.variants.json next to the shader source,
+ * in generated/shaders/<namespace>/variants.h. The declaration tables end with a declaration whose shader is nullptr.
+ */
+struct ShaderVariantDeclaration {
+  /// The name of the shader the variants are made of.
+  gsl::czstring shader;
+  /// The source of the shader, used to compile the variants that weren't precompiled. Can be nullptr.
+  gsl::czstring source_path;
+  /// The defines of the variants separated by spaces. The first one is the lowest bit of the mask.
+  gsl::czstring keys;
+};
+
+/**
+ * @brief A variant that is used but wasn't embedded or cached, given to the ShaderVariantCompiler.
+ */
+struct ShaderVariantRequest {
+  HashedName variant{0};
+  std::string name;
+  std::filesystem::path source;
+  std::vector<std::string> defines;
+};
+
+/**
+ * @brief Compiles a requested variant in the background and hands the binary to ReplaceShaderBinary() when done.
+ */
+using ShaderVariantCompiler = std::function<void(ShaderVariantRequest request)>;
+
+/**
+ * @brief Makes the variant keys of shaders known to GetShaderVariantMask() and to the on demand compilation.
+ * @param declarations A table that ends with a declaration whose shader is nullptr
+ */
+void RegisterShaderVariants(const ShaderVariantDeclaration *declarations);
+
+/**
+ * @brief Builds the mask of a registered shader out of its key names. Unknown keys are reported and ignored.
+ */
+[[nodiscard]] ShaderVariantMask GetShaderVariantMask(HashedName shader, std::initializer_list<std::string_view> keys);
+
+/**
+ * @brief Gets the name of a shader variant to use with GetProgram().
+ * @details Precompiled variants are embedded as <shader>_variant<mask>. Variants that weren't precompiled are read from
+ * the BgfxShaderCache or compiled by the ShaderVariantCompiler and stored in the cache. Until the binary is there
+ * the embedded variant with the most keys of the mask is used instead. The mask 0 is the shader itself.
+ * @code
+ * big2::RegisterEmbeddedShaders(kEmbeddedShaderVariants_examples);
+ * big2::RegisterShaderVariants(kShaderVariants_examples);
+ * const big2::ShaderVariantMask mask = big2::GetShaderVariantMask("fs_basic", {"ALPHA_TEST"});
+ * big2::ProgramReference program = big2::GetProgram("vs_basic", big2::GetShaderVariant("fs_basic", mask));
+ * @endcode
+ */
+[[nodiscard]] HashedName GetShaderVariant(HashedName shader, ShaderVariantMask mask);
+
+/**
+ * @brief Sets what compiles the variants that are neither embedded nor cached, pass nullptr to stop compiling them.
+ * @see ShaderHotReloader
+ */
+void SetShaderVariantCompiler(ShaderVariantCompiler compiler);
+
+/**
+ * @brief Destroys the programs of the registry but keeps the references to them, their next Get() creates them again.
+ * @details BgfxInitializationScoped calls it before BGFX shuts down.
+ */
+void ReleasePrograms();
+
+/**
+ * @return The number of programs that are referenced, whether they were created yet or not.
+ */
+[[nodiscard]] std::size_t GetReferencedProgramCount();
+
+}
+
+#endif //BIG2_STACK_BGFX_PROGRAM_REGISTRY_H_
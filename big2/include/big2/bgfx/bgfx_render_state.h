@@ -0,0 +1,273 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_RENDER_STATE_H_
+#define BIG2_STACK_BGFX_RENDER_STATE_H_
+
+#include <bgfx/bgfx.h>
+#include <cstdint>
+#include <string_view>
+
+namespace big2 {
+
+namespace detail {
+/**
+ * @brief Fails with the reason. It isn't constexpr, so calling it while building a state at compile time is a compile error.
+ */
+void ReportInvalidRenderState(std::string_view reason);
+}
+
+enum class DepthTest : std::uint8_t {
+  None,
+  Less,
+  LessEqual,
+  Equal,
+  GreaterEqual,
+  Greater,
+  NotEqual,
+  Never,
+  Always,
+};
+
+enum class BlendFactor : std::uint8_t {
+  Zero,
+  One,
+  SourceColor,
+  InverseSourceColor,
+  SourceAlpha,
+  InverseSourceAlpha,
+  DestinationAlpha,
+  InverseDestinationAlpha,
+  DestinationColor,
+  InverseDestinationColor,
+  SourceAlphaSaturate,
+  Factor,
+  InverseFactor,
+};
+
+enum class BlendEquation : std::uint8_t {
+  Add,
+  Subtract,
+  ReverseSubtract,
+  Min,
+  Max,
+};
+
+enum class CullMode : std::uint8_t {
+  None,
+  Clockwise,
+  CounterClockwise,
+};
+
+enum class PrimitiveType : std::uint8_t {
+  Triangles,
+  TriangleStrip,
+  Lines,
+  LineStrip,
+  Points,
+};
+
+/**
+ * @brief A typed builder for the BGFX_STATE_* flags given to bgfx::setState().
+ * @details Everything is constexpr, so a state built into a constexpr variable is validated while compiling and
+ * costs nothing at runtime. A state starts without any writes, test, blending or culling.
+ * @code
+ * static constexpr std::uint64_t kState = big2::RenderState()
+ *     .WithColorWrite()
+ *     .WithBlend(big2::BlendFactor::SourceAlpha, big2::BlendFactor::InverseSourceAlpha)
+ *     .WithMsaa();
+ * @endcode
+ */
+class RenderState final {
+ public:
+  constexpr RenderState() = default;
+
+  /**
+   * @brief The state BGFX uses when none is set: color and depth writes, less depth test, clockwise culling and MSAA.
+   */
+  [[nodiscard]] static constexpr RenderState Default() {
+    return RenderState().WithColorWrite().WithDepthWrite().WithDepthTest(DepthTest::Less).WithCull(CullMode::Clockwise).WithMsaa();
+  }
+
+  [[nodiscard]] constexpr RenderState WithColorWrite(bool red = true, bool green = true, bool blue = true, bool alpha = true) const {
+    return With(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A,
+                (red ? BGFX_STATE_WRITE_R : 0) | (green ? BGFX_STATE_WRITE_G : 0) | (blue ? BGFX_STATE_WRITE_B : 0) | (alpha ? BGFX_STATE_WRITE_A : 0));
+  }
+
+  [[nodiscard]] constexpr RenderState WithDepthWrite(bool enabled = true) const {
+    return With(BGFX_STATE_WRITE_Z, enabled ? BGFX_STATE_WRITE_Z : 0);
+  }
+
+  [[nodiscard]] constexpr RenderState WithDepthTest(DepthTest test) const {
+    return With(BGFX_STATE_DEPTH_TEST_MASK, ToFlags(test));
+  }
+
+  [[nodiscard]] constexpr RenderState WithBlend(BlendFactor source, BlendFactor destination) const {
+    return With(BGFX_STATE_BLEND_MASK, BGFX_STATE_BLEND_FUNC(ToFlags(source), ToFlags(destination)));
+  }
+
+  [[nodiscard]] constexpr RenderState WithBlend(BlendFactor source_color, BlendFactor destination_color, BlendFactor source_alpha, BlendFactor destination_alpha) const {
+    return With(BGFX_STATE_BLEND_MASK,
+                BGFX_STATE_BLEND_FUNC_SEPARATE(ToFlags(source_color), ToFlags(destination_color), ToFlags(source_alpha), ToFlags(destination_alpha)));
+  }
+
+  [[nodiscard]] constexpr RenderState WithBlendEquation(BlendEquation equation) const {
+    return With(BGFX_STATE_BLEND_EQUATION_MASK, BGFX_STATE_BLEND_EQUATION(ToFlags(equation)));
+  }
+
+  [[nodiscard]] constexpr RenderState WithBlendEquation(BlendEquation color, BlendEquation alpha) const {
+    return With(BGFX_STATE_BLEND_EQUATION_MASK, BGFX_STATE_BLEND_EQUATION_SEPARATE(ToFlags(color), ToFlags(alpha)));
+  }
+
+  [[nodiscard]] constexpr RenderState WithAlphaToCoverage(bool enabled = true) const {
+    return With(BGFX_STATE_BLEND_ALPHA_TO_COVERAGE, enabled ? BGFX_STATE_BLEND_ALPHA_TO_COVERAGE : 0);
+  }
+
+  [[nodiscard]] constexpr RenderState WithCull(CullMode mode) const {
+    return With(BGFX_STATE_CULL_MASK, ToFlags(mode));
+  }
+
+  [[nodiscard]] constexpr RenderState WithCounterClockwiseFront(bool enabled = true) const {
+    return With(BGFX_STATE_FRONT_CCW, enabled ? BGFX_STATE_FRONT_CCW : 0);
+  }
+
+  [[nodiscard]] constexpr RenderState WithPrimitive(PrimitiveType type) const {
+    return With(BGFX_STATE_PT_MASK, ToFlags(type));
+  }
+
+  [[nodiscard]] constexpr RenderState WithMsaa(bool enabled = true) const {
+    return With(BGFX_STATE_MSAA, enabled ? BGFX_STATE_MSAA : 0);
+  }
+
+  [[nodiscard]] constexpr RenderState WithLineAntialiasing(bool enabled = true) const {
+    return With(BGFX_STATE_LINEAA, enabled ? BGFX_STATE_LINEAA : 0);
+  }
+
+  /**
+   * @return Why the combination makes no sense or an empty string if it is fine.
+   */
+  [[nodiscard]] constexpr std::string_view GetValidationError() const {
+    const bool is_blending = (state_ & BGFX_STATE_BLEND_MASK) != 0;
+    const bool is_writing_color = (state_ & (BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A)) != 0;
+    const std::uint64_t primitive = state_ & BGFX_STATE_PT_MASK;
+    const bool is_line = primitive == BGFX_STATE_PT_LINES || primitive == BGFX_STATE_PT_LINESTRIP;
+
+    if (is_blending && !is_writing_color) {
+      return "Blending is set but no color channel is written";
+    }
+    if ((state_ & BGFX_STATE_BLEND_EQUATION_MASK) != 0 && !is_blending) {
+      return "A blend equation is set without blend factors";
+    }
+    if ((state_ & BGFX_STATE_BLEND_ALPHA_TO_COVERAGE) != 0 && (state_ & BGFX_STATE_MSAA) == 0) {
+      return "Alpha to coverage needs MSAA";
+    }
+    if ((state_ & BGFX_STATE_LINEAA) != 0 && !is_line) {
+      return "Line antialiasing is set for a primitive that isn't a line";
+    }
+    if ((state_ & BGFX_STATE_CULL_MASK) != 0 && (is_line || primitive == BGFX_STATE_PT_POINTS)) {
+      return "Culling is set for lines or points";
+    }
+    return {};
+  }
+
+  /**
+   * @brief Gets the flags for bgfx::setState(), failing if the combination is invalid.
+   */
+  [[nodiscard]] constexpr std::uint64_t Get() const {
+    if (const std::string_view error = GetValidationError(); !error.empty()) {
+      detail::ReportInvalidRenderState(error);
+    }
+    return state_;
+  }
+
+  explicit(false) constexpr operator std::uint64_t() const { return Get(); }
+
+  friend constexpr bool operator==(const RenderState &, const RenderState &) = default;
+
+ private:
+  constexpr explicit RenderState(std::uint64_t state) : state_(state) {}
+
+  [[nodiscard]] constexpr RenderState With(std::uint64_t mask, std::uint64_t flags) const {
+    return RenderState((state_ & ~mask) | flags);
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t ToFlags(DepthTest test) {
+    switch (test) {
+      case DepthTest::Less: return BGFX_STATE_DEPTH_TEST_LESS;
+      case DepthTest::LessEqual: return BGFX_STATE_DEPTH_TEST_LEQUAL;
+      case DepthTest::Equal: return BGFX_STATE_DEPTH_TEST_EQUAL;
+      case DepthTest::GreaterEqual: return BGFX_STATE_DEPTH_TEST_GEQUAL;
+      case DepthTest::Greater: return BGFX_STATE_DEPTH_TEST_GREATER;
+      case DepthTest::NotEqual: return BGFX_STATE_DEPTH_TEST_NOTEQUAL;
+      case DepthTest::Never: return BGFX_STATE_DEPTH_TEST_NEVER;
+      case DepthTest::Always: return BGFX_STATE_DEPTH_TEST_ALWAYS;
+      default: return 0;
+    }
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t ToFlags(BlendFactor factor) {
+    switch (factor) {
+      case BlendFactor::Zero: return BGFX_STATE_BLEND_ZERO;
+      case BlendFactor::One: return BGFX_STATE_BLEND_ONE;
+      case BlendFactor::SourceColor: return BGFX_STATE_BLEND_SRC_COLOR;
+      case BlendFactor::InverseSourceColor: return BGFX_STATE_BLEND_INV_SRC_COLOR;
+      case BlendFactor::SourceAlpha: return BGFX_STATE_BLEND_SRC_ALPHA;
+      case BlendFactor::InverseSourceAlpha: return BGFX_STATE_BLEND_INV_SRC_ALPHA;
+      case BlendFactor::DestinationAlpha: return BGFX_STATE_BLEND_DST_ALPHA;
+      case BlendFactor::InverseDestinationAlpha: return BGFX_STATE_BLEND_INV_DST_ALPHA;
+      case BlendFactor::DestinationColor: return BGFX_STATE_BLEND_DST_COLOR;
+      case BlendFactor::InverseDestinationColor: return BGFX_STATE_BLEND_INV_DST_COLOR;
+      case BlendFactor::SourceAlphaSaturate: return BGFX_STATE_BLEND_SRC_ALPHA_SAT;
+      case BlendFactor::Factor: return BGFX_STATE_BLEND_FACTOR;
+      case BlendFactor::InverseFactor: return BGFX_STATE_BLEND_INV_FACTOR;
+      default: return 0;
+    }
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t ToFlags(BlendEquation equation) {
+    switch (equation) {
+      case BlendEquation::Add: return BGFX_STATE_BLEND_EQUATION_ADD;
+      case BlendEquation::Subtract: return BGFX_STATE_BLEND_EQUATION_SUB;
+      case BlendEquation::ReverseSubtract: return BGFX_STATE_BLEND_EQUATION_REVSUB;
+      case BlendEquation::Min: return BGFX_STATE_BLEND_EQUATION_MIN;
+      case BlendEquation::Max: return BGFX_STATE_BLEND_EQUATION_MAX;
+      default: return 0;
+    }
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t ToFlags(CullMode mode) {
+    switch (mode) {
+      case CullMode::Clockwise: return BGFX_STATE_CULL_CW;
+      case CullMode::CounterClockwise: return BGFX_STATE_CULL_CCW;
+      default: return 0;
+    }
+  }
+
+  [[nodiscard]] static constexpr std::uint64_t ToFlags(PrimitiveType type) {
+    switch (type) {
+      case PrimitiveType::TriangleStrip: return BGFX_STATE_PT_TRISTRIP;
+      case PrimitiveType::Lines: return BGFX_STATE_PT_LINES;
+      case PrimitiveType::LineStrip: return BGFX_STATE_PT_LINESTRIP;
+      case PrimitiveType::Points: return BGFX_STATE_PT_POINTS;
+      default: return 0;
+    }
+  }
+
+  std::uint64_t state_ = BGFX_STATE_NONE;
+};
+
+/**
+ * @brief Makes a key that sorts draws so the ones sharing a program, then a state, then a texture end up next to each other.
+ * @details The program is the most expensive to switch and takes the highest bits, the state is folded into 32 bits.
+ * Only sort draws whose order doesn't matter, like opaque ones. Blended draws usually have to keep their order.
+ */
+[[nodiscard]] constexpr std::uint64_t MakeRenderSortKey(std::uint64_t state, bgfx::ProgramHandle program, bgfx::TextureHandle texture) {
+  const auto folded_state = static_cast<std::uint32_t>(state ^ (state >> 32));
+  return (static_cast<std::uint64_t>(program.idx) << 48) | (static_cast<std::uint64_t>(folded_state) << 16) | texture.idx;
+}
+
+}
+
+#endif //BIG2_STACK_BGFX_RENDER_STATE_H_
@@ -0,0 +1,110 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_RENDER_TARGET_POOL_H_
+#define BIG2_STACK_BGFX_RENDER_TARGET_POOL_H_
+
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+
+namespace big2 {
+
+/**
+ * @brief Describes an offscreen render target. Targets with equal descriptors are interchangeable.
+ */
+struct RenderTargetDescriptor {
+  glm::u16vec2 size{0, 0};
+  bgfx::TextureFormat::Enum color_format = bgfx::TextureFormat::RGBA8;
+  /// Set to bgfx::TextureFormat::Count for a target without depth.
+  bgfx::TextureFormat::Enum depth_format = bgfx::TextureFormat::Count;
+  /// Sampler flags for the color texture. BGFX_TEXTURE_RT is always added.
+  std::uint64_t flags = BGFX_SAMPLER_U_CLAMP | BGFX_SAMPLER_V_CLAMP;
+
+  friend bool operator==(const RenderTargetDescriptor &, const RenderTargetDescriptor &) = default;
+};
+
+struct RenderTargetDescriptorHash {
+  std::size_t operator()(const RenderTargetDescriptor &descriptor) const;
+};
+
+struct PooledRenderTarget {
+  bgfx::FrameBufferHandle frame_buffer = BGFX_INVALID_HANDLE;
+  bgfx::TextureHandle color = BGFX_INVALID_HANDLE;
+  bgfx::TextureHandle depth = BGFX_INVALID_HANDLE;
+  RenderTargetDescriptor descriptor;
+  std::uint64_t byte_estimate = 0;
+
+  [[nodiscard]] bool IsValid() const { return bgfx::isValid(frame_buffer); }
+};
+
+/**
+ * @brief Reuses offscreen render targets instead of creating and destroying them every time they are needed.
+ * @details Released targets stay allocated and are handed out again to requests with the same descriptor.
+ * When the memory of all targets goes over the cap, the least recently released ones are destroyed.
+ * Targets in use are never evicted.
+ * @note Window swapchains can't be pooled since they are bound to their native window.
+ * @see GetRenderTargetPool()
+ */
+class BgfxRenderTargetPool final {
+ public:
+  BgfxRenderTargetPool() = default;
+  BgfxRenderTargetPool(BgfxRenderTargetPool &&) = delete;
+  BgfxRenderTargetPool &operator=(BgfxRenderTargetPool &&) = delete;
+  BgfxRenderTargetPool(const BgfxRenderTargetPool &) = delete;
+  BgfxRenderTargetPool &operator=(const BgfxRenderTargetPool &) = delete;
+  /**
+   * @brief Drops the free targets without destroying them, BGFX may already be shut down when the pool goes away.
+   */
+  ~BgfxRenderTargetPool() = default;
+
+  /**
+   * @brief Gets a free target that matches the descriptor or creates one.
+   */
+  [[nodiscard]] PooledRenderTarget Acquire(const RenderTargetDescriptor &descriptor);
+
+  /**
+   * @brief Gives the target back to the pool.
+   * @details The target can be handed out again in the same frame, so release it only after the last view
+   * that reads it was set up. Views of the next user have to be ordered after those views.
+   */
+  void Release(const PooledRenderTarget &target);
+
+  /**
+   * @brief Sets how much memory the pool may keep in free and used targets before it starts evicting free ones.
+   */
+  void SetMemoryCap(std::uint64_t bytes);
+  [[nodiscard]] std::uint64_t GetMemoryCap() const { return memory_cap_; }
+
+  /**
+   * @brief Destroys all free targets. BgfxInitializationScoped calls it before BGFX shuts down.
+   */
+  void Clear();
+
+  [[nodiscard]] std::uint64_t GetUsedBytes() const { return used_bytes_; }
+  [[nodiscard]] std::uint64_t GetFreeBytes() const { return free_bytes_; }
+  [[nodiscard]] std::size_t GetFreeCount() const { return free_targets_.size(); }
+
+ private:
+  using FreeList = std::list<PooledRenderTarget>;
+
+  static PooledRenderTarget Create(const RenderTargetDescriptor &descriptor);
+  static void Destroy(const PooledRenderTarget &target);
+  void EvictOverCap();
+  void EvictLeastRecentlyUsed();
+
+  // Most recently released targets are at the front
+  FreeList free_targets_;
+  std::unordered_multimap<RenderTargetDescriptor, FreeList::iterator, RenderTargetDescriptorHash> free_targets_by_descriptor_;
+  std::uint64_t used_bytes_ = 0;
+  std::uint64_t free_bytes_ = 0;
+  std::uint64_t memory_cap_ = 256ull * 1024 * 1024;
+};
+
+}
+
+#endif //BIG2_STACK_BGFX_RENDER_TARGET_POOL_H_
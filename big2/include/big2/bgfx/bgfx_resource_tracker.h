@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_RESOURCE_TRACKER_H_
+#define BIG2_STACK_BGFX_RESOURCE_TRACKER_H_
+
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include <big2/asserts.h>
+#include <big2/bgfx/bgfx_handle_registry.h>
+
+namespace big2 {
+
+/**
+ * @brief The kinds of GPU resources the tracker accounts for.
+ * @details These are the bgfx handle types in the same order as BgfxHandleType plus the reserved views.
+ */
+enum class BgfxResourceCategory : std::uint8_t {
+  DynamicIndexBuffer,
+  DynamicVertexBuffer,
+  FrameBuffer,
+  IndexBuffer,
+  IndirectBuffer,
+  OcclusionQuery,
+  Program,
+  Shader,
+  Texture,
+  Uniform,
+  VertexBuffer,
+  VertexLayout,
+  View,
+  Count,
+};
+
+[[nodiscard]] constexpr BgfxResourceCategory ToResourceCategory(BgfxHandleType type) {
+  return static_cast<BgfxResourceCategory>(type);
+}
+
+[[nodiscard]] gsl::czstring GetResourceCategoryName(BgfxResourceCategory category);
+
+struct TrackedResource {
+  BgfxResourceCategory category;
+  std::uint16_t index;
+  /// Unique for every tracked creation so recycled indices can be told apart.
+  std::uint64_t serial;
+  /// An estimate of the GPU memory used by the resource, 0 if unknown.
+  std::uint64_t byte_estimate;
+  /// The value of GetSubmittedFrameCount() when the resource was created.
+  std::uint32_t creation_frame;
+  std::source_location location;
+};
+
+struct BgfxResourceTotals {
+  std::uint32_t count = 0;
+  std::uint64_t bytes = 0;
+};
+
+/**
+ * @brief All resources that were alive when the snapshot was taken, ordered by their serial.
+ */
+struct BgfxResourceSnapshot {
+  std::vector<TrackedResource> resources;
+};
+
+struct BgfxResourceSnapshotDiff {
+  std::vector<TrackedResource> created;
+  std::vector<TrackedResource> destroyed;
+
+  [[nodiscard]] std::int64_t GetByteGrowth() const;
+};
+
+/**
+ * @brief Records a resource created through one of BIG2's creation paths.
+ * @return The same handle to allow wrapping the creation call.
+ */
+template<typename BgfxType>
+BgfxType TrackResource(BgfxType handle, std::uint64_t byte_estimate = 0, const std::source_location location = std::source_location::current());
+
+/**
+ * @brief Forgets a resource when it is destroyed. Resources that were never tracked are ignored.
+ */
+template<typename BgfxType>
+void UntrackResource(BgfxType handle);
+
+void TrackView(bgfx::ViewId view_id, const std::source_location location = std::source_location::current());
+void UntrackView(bgfx::ViewId view_id);
+
+/**
+ * @brief Estimates the memory of a texture from its size and format using bgfx::calcTextureSize().
+ */
+[[nodiscard]] std::uint64_t EstimateTextureBytes(glm::u16vec2 size, bool has_mips, std::uint16_t layers_count, bgfx::TextureFormat::Enum format);
+
+/**
+ * @brief Estimates the memory of a window swapchain as a double buffered RGBA8 color buffer with a D24S8 depth buffer.
+ */
+[[nodiscard]] std::uint64_t EstimateWindowFrameBufferBytes(glm::u16vec2 size);
+
+[[nodiscard]] BgfxResourceTotals GetResourceTotals(BgfxResourceCategory category);
+[[nodiscard]] BgfxResourceTotals GetResourceTotals();
+
+[[nodiscard]] BgfxResourceSnapshot TakeResourceSnapshot();
+
+/**
+ * @brief Finds what was created and destroyed between two snapshots.
+ * @details Taking a snapshot every frame and diffing it with the previous one shows per-frame growth.
+ */
+[[nodiscard]] BgfxResourceSnapshotDiff DiffResourceSnapshots(const BgfxResourceSnapshot &before, const BgfxResourceSnapshot &after);
+
+/**
+ * @brief Logs a warning with the creation site of every resource that is still alive.
+ * @details Called by BgfxInitializationScoped right before BGFX is shut down.
+ * @return The number of leaked resources.
+ */
+std::size_t ReportResourceLeaks();
+
+/**
+ * @brief Forgets every tracked resource.
+ * @details Called by BgfxInitializationScoped after BGFX is shut down, the handles of the old BGFX instance mean nothing
+ * to the next one and their indices get reused.
+ */
+void ClearTrackedResources();
+
+namespace detail {
+void TrackResource(BgfxResourceCategory category, std::uint16_t index, std::uint64_t byte_estimate, const std::source_location &location);
+void UntrackResource(BgfxResourceCategory category, std::uint16_t index);
+}
+
+template<typename BgfxType>
+BgfxType TrackResource(BgfxType handle, std::uint64_t byte_estimate, const std::source_location location) {
+  static_assert(kBgfxHandleType<BgfxType> != BgfxHandleType::Count, "Not a bgfx handle that can be tracked");
+  if (bgfx::isValid(handle)) {
+    detail::TrackResource(ToResourceCategory(kBgfxHandleType<BgfxType>), handle.idx, byte_estimate, location);
+  }
+  return handle;
+}
+
+template<typename BgfxType>
+void UntrackResource(BgfxType handle) {
+  static_assert(kBgfxHandleType<BgfxType> != BgfxHandleType::Count, "Not a bgfx handle that can be tracked");
+  if (bgfx::isValid(handle)) {
+    detail::UntrackResource(ToResourceCategory(kBgfxHandleType<BgfxType>), handle.idx);
+  }
+}
+
+}
+
+#endif //BIG2_STACK_BGFX_RESOURCE_TRACKER_H_
@@ -6,26 +6,56 @@
 #ifndef BGFX_SCOPED_HANDLE_H
 #define BGFX_SCOPED_HANDLE_H
 
+#include <bgfx/bgfx.h>
+#include <big2/asserts.h>
+#include <big2/bgfx/bgfx_handle_registry.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+
 namespace big2 {
+
+/**
+ * @brief Owns a bgfx handle and destroys it when it goes out of scope or gets replaced.
+ * @details The destruction is deferred until the frames that could still use the handle are done.
+ * With BIG2_CHECKED_HANDLES enabled the handle also remembers the generation of its index,
+ * so using it after the index was destroyed through the destruction queue (and possibly recycled by bgfx)
+ * is reported instead of silently affecting another resource. Indices destroyed with bgfx::destroy() directly
+ * aren't seen by the check.
+ */
 template<typename BgfxType>
 struct BgfxScopedHandle {
   BgfxScopedHandle() = default;
   explicit(false) BgfxScopedHandle(BgfxType handle)
     : handle_(handle) {
+    Acquire();
   }
   BgfxScopedHandle &operator=(const BgfxType &handle) {
+    Destroy();
     handle_ = handle;
+    Acquire();
     return *this;
   }
   BgfxScopedHandle(const BgfxScopedHandle &) = delete;
   BgfxScopedHandle &operator=(const BgfxScopedHandle &) = delete;
   BgfxScopedHandle(BgfxScopedHandle &&other) noexcept
     : handle_(other.handle_) {
+#if BIG2_CHECKED_HANDLES
+    tracked_handle_ = other.tracked_handle_;
+    generation_ = other.generation_;
+    other.tracked_handle_ = BGFX_INVALID_HANDLE;
+#endif // BIG2_CHECKED_HANDLES
     other.handle_ = BGFX_INVALID_HANDLE;
   }
   BgfxScopedHandle &operator=(BgfxScopedHandle &&other) noexcept {
-    handle_ = other.handle_;
-    other.handle_ = BGFX_INVALID_HANDLE;
+    if (this != &other) {
+      Destroy();
+      handle_ = other.handle_;
+#if BIG2_CHECKED_HANDLES
+      tracked_handle_ = other.tracked_handle_;
+      generation_ = other.generation_;
+      other.tracked_handle_ = BGFX_INVALID_HANDLE;
+#endif // BIG2_CHECKED_HANDLES
+      other.handle_ = BGFX_INVALID_HANDLE;
+    }
     return *this;
   }
 
@@ -34,23 +64,70 @@ struct BgfxScopedHandle {
   }
 
   explicit(false) operator BgfxType() const {
+    Check();
     return handle_;
   }
 
+  /**
+   * @details Code that changes the handle through this reference is allowed to destroy and recreate it,
+   * the new index is picked up on the next access.
+   */
   explicit(false) operator BgfxType &() {
+    Check();
     return handle_;
   }
 
   [[nodiscard]] bool IsValid() const { return bgfx::isValid(handle_); }
 
   void Destroy() {
+    Check();
     if (IsValid()) {
-      bgfx::destroy(handle_);
+      big2::DestroyDeferred(handle_);
+      Release();
       handle_ = BGFX_INVALID_HANDLE;
     }
   }
 
   BgfxType handle_ = BGFX_INVALID_HANDLE;
+
+ private:
+#if BIG2_CHECKED_HANDLES
+  // Const since the tracking is resynchronized when a changed handle is read through a const conversion
+  void Acquire() const {
+    tracked_handle_ = handle_;
+    if (bgfx::isValid(handle_)) {
+      generation_ = detail::OnBgfxHandleAcquired(kBgfxHandleType<BgfxType>, handle_.idx);
+    }
+  }
+
+  void Release() const {
+    if (bgfx::isValid(tracked_handle_)) {
+      detail::OnBgfxHandleReleased(kBgfxHandleType<BgfxType>, tracked_handle_.idx);
+    }
+    tracked_handle_ = BGFX_INVALID_HANDLE;
+  }
+
+  void Check() const {
+    if (tracked_handle_.idx != handle_.idx) {
+      // The handle was replaced through the reference conversion so the old index is no longer owned by us
+      Release();
+      Acquire();
+      return;
+    }
+
+    if (bgfx::isValid(handle_)) {
+      big2::SoftValidate(detail::GetBgfxHandleGeneration(kBgfxHandleType<BgfxType>, handle_.idx) == generation_,
+                         "Using a stale bgfx handle whose index was destroyed and possibly reused");
+    }
+  }
+
+  mutable BgfxType tracked_handle_ = BGFX_INVALID_HANDLE;
+  mutable detail::BgfxHandleGeneration generation_ = 0;
+#else
+  void Acquire() const {}
+  void Release() const {}
+  void Check() const {}
+#endif // BIG2_CHECKED_HANDLES
 };
 
 using DynamicIndexBufferScopedHandle = BgfxScopedHandle<bgfx::DynamicIndexBufferHandle>;
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_SHADER_CACHE_H_
+#define BIG2_STACK_BGFX_SHADER_CACHE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+namespace big2 {
+
+struct BgfxShaderCacheStatistics {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t writes = 0;
+  std::uint64_t evictions = 0;
+};
+
+/**
+ * @brief A scoped singleton that keeps the shader and program binaries BGFX compiles at runtime on disk.
+ * @details BgfxCallbackHandler forwards BGFX's cache callbacks to the active instance, so renderers that compile
+ * shaders while running (like OpenGL) can skip that work on the next launch. Create it before BGFX is initialized.
+ * Every entry is stored in its own file named after the BGFX cache id. The index with the sizes, checksums and
+ * usage order of the entries is memory-mapped when the cache is opened. Entries and the index are written to a
+ * temporary file first and then renamed, so a crash never leaves a half written file behind.
+ * When the entries go over the size limit, the least recently used ones are deleted.
+ * The callbacks come from the BGFX render thread, all methods are thread safe.
+ */
+class BgfxShaderCache final {
+ public:
+  explicit BgfxShaderCache(std::filesystem::path directory, std::uint64_t max_bytes = 64ull * 1024 * 1024);
+  BgfxShaderCache(BgfxShaderCache &&) = delete;
+  BgfxShaderCache &operator=(BgfxShaderCache &&) = delete;
+  BgfxShaderCache(const BgfxShaderCache &) = delete;
+  BgfxShaderCache &operator=(const BgfxShaderCache &) = delete;
+  ~BgfxShaderCache();
+
+  static BgfxShaderCache *GetInstance() { return instance_; }
+
+  /**
+   * @return The size of the cached binary or 0 if there is no entry with this id.
+   */
+  [[nodiscard]] std::uint32_t GetEntrySize(std::uint64_t id);
+
+  /**
+   * @brief Reads the binary into data. Entries that are missing or damaged on disk are dropped.
+   * @return True on a cache hit.
+   */
+  bool Read(std::uint64_t id, void *data, std::uint32_t size);
+
+  void Write(std::uint64_t id, const void *data, std::uint32_t size);
+
+  /**
+   * @brief Deletes all entries from disk.
+   */
+  void Clear();
+
+  void SetMaxBytes(std::uint64_t bytes);
+  [[nodiscard]] std::uint64_t GetMaxBytes() const { return max_bytes_; }
+  [[nodiscard]] std::uint64_t GetTotalBytes() const;
+  [[nodiscard]] std::size_t GetEntryCount() const;
+  [[nodiscard]] BgfxShaderCacheStatistics GetStatistics() const;
+  [[nodiscard]] const std::filesystem::path &GetDirectory() const { return directory_; }
+
+ private:
+  struct Entry {
+    std::uint32_t size = 0;
+    std::uint32_t checksum = 0;
+    std::uint64_t last_use = 0;
+  };
+
+  [[nodiscard]] std::filesystem::path GetEntryPath(std::uint64_t id) const;
+  void LoadIndex();
+  void SaveIndex();
+  void EvictOverLimit();
+  void RemoveEntry(std::uint64_t id);
+
+  static BgfxShaderCache *instance_;
+
+  mutable std::mutex mutex_;
+  std::filesystem::path directory_;
+  std::unordered_map<std::uint64_t, Entry> entries_;
+  std::uint64_t max_bytes_;
+  std::uint64_t total_bytes_ = 0;
+  std::uint64_t next_use_ = 0;
+  bool is_index_dirty_ = false;
+  BgfxShaderCacheStatistics statistics_;
+};
+
+}
+
+#endif //BIG2_STACK_BGFX_SHADER_CACHE_H_
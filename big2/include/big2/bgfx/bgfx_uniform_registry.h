@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_UNIFORM_REGISTRY_H_
+#define BIG2_STACK_BGFX_UNIFORM_REGISTRY_H_
+
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace big2 {
+
+namespace detail {
+
+/**
+ * @brief Changes whenever the uniforms of the registry were destroyed.
+ */
+[[nodiscard]] std::uint32_t GetUniformsGeneration();
+
+}
+
+/**
+ * @brief Gets the uniform with the name, creating it the first time the name is used.
+ * @details All callers share one handle per name, the names are hashed so looking a uniform up is cheap.
+ * Asking for a name again with another type or count fails validation.
+ * The uniforms are destroyed by BgfxInitializationScoped before BGFX shuts down, don't destroy them yourself.
+ */
+[[nodiscard]] bgfx::UniformHandle GetUniform(std::string_view name, bgfx::UniformType::Enum type, std::uint16_t count = 1);
+
+/**
+ * @brief Destroys the uniforms of the registry. BgfxInitializationScoped calls it before BGFX shuts down.
+ */
+void ReleaseUniforms();
+
+/**
+ * @return The number of uniforms in the registry.
+ */
+[[nodiscard]] std::size_t GetUniformCount();
+
+/**
+ * @brief A struct that can be copied into an array of vec4s, i.e. plain data made of 4 byte values.
+ * @details Only the size and alignment can be checked, the members have to be floats or glm float vectors since
+ * the shader reads everything as floats. Lay them out in rows of four floats, like a glm::vec3 followed by a float.
+ */
+template<typename TBlock>
+concept UniformBlockType = std::is_trivially_copyable_v<TBlock> && std::is_standard_layout_v<TBlock>
+    && sizeof(TBlock) % sizeof(float) == 0 && alignof(TBlock) <= alignof(glm::vec4);
+
+/**
+ * @brief A struct sent to the shaders as one vec4 array uniform, so all its values take a single bgfx::setUniform().
+ * @details The number of vec4s is known at compile time and the values are only packed again after they changed.
+ * The shader declares the block as an array and unpacks it, e.g. with #defines.
+ * @code
+ * struct Material {
+ *   glm::vec4 color;
+ *   glm::vec3 light_direction;
+ *   float roughness;
+ * };
+ *
+ * // uniform vec4 u_material[2]; in the shader
+ * big2::UniformBlock<Material> material("u_material");
+ * material.Edit().roughness = 0.5f;
+ * material.Apply();
+ * bgfx::submit(view_id, program);
+ * @endcode
+ */
+template<UniformBlockType TBlock>
+class UniformBlock final {
+ public:
+  static constexpr std::uint16_t kVec4Count = (sizeof(TBlock) + sizeof(glm::vec4) - 1) / sizeof(glm::vec4);
+
+  explicit UniformBlock(std::string name, const TBlock &value = {}) : name_(std::move(name)), value_(value) {}
+
+  [[nodiscard]] const TBlock &Get() const { return value_; }
+
+  /**
+   * @brief Gets the values for changing them, the block is sent again on the next Apply().
+   */
+  [[nodiscard]] TBlock &Edit() {
+    is_dirty_ = true;
+    return value_;
+  }
+
+  void Set(const TBlock &value) {
+    value_ = value;
+    is_dirty_ = true;
+  }
+
+  /**
+   * @brief Sets the uniform for the next submitted draw.
+   * @details It is set for every draw, BGFX sorts the draws of a frame so skipping unchanged values isn't safe.
+   */
+  void Apply() {
+    if (generation_ != detail::GetUniformsGeneration()) {
+      handle_ = GetUniform(name_, bgfx::UniformType::Vec4, kVec4Count);
+      generation_ = detail::GetUniformsGeneration();
+    }
+
+    if (is_dirty_) {
+      std::memcpy(packed_.data(), &value_, sizeof(TBlock));
+      is_dirty_ = false;
+    }
+    bgfx::setUniform(handle_, packed_.data(), kVec4Count);
+  }
+
+  [[nodiscard]] const std::string &GetName() const { return name_; }
+
+ private:
+  std::string name_;
+  TBlock value_;
+  std::array<glm::vec4, kVec4Count> packed_{};
+  bool is_dirty_ = true;
+  bgfx::UniformHandle handle_ = BGFX_INVALID_HANDLE;
+  std::uint32_t generation_ = 0;
+};
+
+}
+
+#endif //BIG2_STACK_BGFX_UNIFORM_REGISTRY_H_
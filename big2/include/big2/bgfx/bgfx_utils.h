@@ -10,9 +10,11 @@
 #include <glm/glm.hpp>
 #include <gsl/gsl>
 #include <vector>
+#include <big2/asserts.h>
 #include <big2/bgfx/bgfx_frame_buffer_scoped.h>
 #include <big2/bgfx/bgfx_view_scoped.h>
 #include <big2/bgfx/bgfx_initialization_scoped.h>
+#include <big2/bgfx/bgfx_render_target_pool.h>
 
 struct GLFWwindow;
 
@@ -26,25 +28,53 @@ namespace big2 {
  */
 void SetNativeWindowData(bgfx::Init &init_obj, gsl::not_null<GLFWwindow *> window);
 
+/**
+ * @brief Adds only the native display to the platform data.
+ * @details BGFX only allows changing the window after initialization if the display stays the same,
+ * so headless initializations that bind windows later have to set it upfront.
+ * @param platform_data The platform data that will be passed to BGFX
+ */
+void SetNativeDisplayData(bgfx::PlatformData &platform_data);
+
 /**
  * @brief Creates a frame buffer for the given window.
  * @param window An initialized window handle
+ * @param location The creation site recorded by the resource tracker
  * @return A handle to the frame buffer. You would likely need to link this to a bgfx::ViewId through bgfx::setViewFrameBuffer
  */
-[[nodiscard]] bgfx::FrameBufferHandle CreateWindowFrameBuffer(gsl::not_null<GLFWwindow *> window);
+[[nodiscard]] bgfx::FrameBufferHandle CreateWindowFrameBuffer(gsl::not_null<GLFWwindow *> window, const std::source_location location = std::source_location::current());
 
 /**
  * @brief Updates an existing framebuffer handle by destroying the current framebuffer and then recreating it.
  * @param window An initialized window handle
  * @param out_handle A handle to the frame buffer.
+ * @param location The creation site recorded by the resource tracker
+ */
+void ResetWindowFrameBuffer(gsl::not_null<GLFWwindow *> window, bgfx::FrameBufferHandle &out_handle, const std::source_location location = std::source_location::current());
+
+/**
+ * @brief Creates a static vertex buffer that the resource tracker knows about, sized by the memory it is made from.
+ * @param location The creation site recorded by the resource tracker
+ */
+[[nodiscard]] bgfx::VertexBufferHandle CreateVertexBuffer(const bgfx::Memory *memory,
+                                                          const bgfx::VertexLayout &layout,
+                                                          std::uint16_t flags = BGFX_BUFFER_NONE,
+                                                          const std::source_location location = std::source_location::current());
+
+/**
+ * @brief Creates a static index buffer that the resource tracker knows about, sized by the memory it is made from.
+ * @param location The creation site recorded by the resource tracker
  */
-void ResetWindowFrameBuffer(gsl::not_null<GLFWwindow *> window, bgfx::FrameBufferHandle &out_handle);
+[[nodiscard]] bgfx::IndexBufferHandle CreateIndexBuffer(const bgfx::Memory *memory,
+                                                        std::uint16_t flags = BGFX_BUFFER_NONE,
+                                                        const std::source_location location = std::source_location::current());
 
 /**
  * @brief BIG2 will use an IdManager class to reserve and monitor ViewIds
+ * @details Reserving and freeing ViewIds is lock-free and can be done from any thread.
  * @return The first free ViewId (that isn't reserved by this function)
  */
-[[nodiscard]] bgfx::ViewId ReserveViewId();
+[[nodiscard]] bgfx::ViewId ReserveViewId(const std::source_location location = std::source_location::current());
 
 /**
  * @brief Get the ViewIds that were reserved by BIG2's ReserveViewId()
@@ -58,6 +88,22 @@ void ResetWindowFrameBuffer(gsl::not_null<GLFWwindow *> window, bgfx::FrameBuffe
  */
 void FreeViewId(bgfx::ViewId value);
 
+/**
+ * @brief Gets the pool that BIG2 uses for offscreen render targets.
+ * @details The pool is cleared when BgfxInitializationScoped shuts BGFX down.
+ */
+[[nodiscard]] BgfxRenderTargetPool &GetRenderTargetPool();
+
+/**
+ * @brief Gets an offscreen render target from the shared pool, reusing a released one with the same descriptor if possible.
+ */
+[[nodiscard]] PooledRenderTarget AcquireRenderTarget(const RenderTargetDescriptor &descriptor);
+
+/**
+ * @brief Gives a render target back to the shared pool.
+ */
+void ReleaseRenderTarget(const PooledRenderTarget &target);
+
 /**
  * \brief Checks after initialization if bgfx is capable of rendering to multiple windows.
  */
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_BGFX_VERTEX_LAYOUT_H_
+#define BIG2_STACK_BGFX_VERTEX_LAYOUT_H_
+
+#include <bgfx/bgfx.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace big2 {
+
+/**
+ * @brief Describes how one member of a vertex struct is read by the vertex shader.
+ * @see BIG2_VERTEX_ATTRIBUTE
+ */
+struct VertexAttribute {
+  bgfx::Attrib::Enum attribute;
+  std::uint8_t count;
+  bgfx::AttribType::Enum type;
+  bool is_normalized;
+  std::size_t offset;
+  std::size_t size;
+  bool is_integer;
+};
+
+/**
+ * @brief Specialize it with a constexpr std::array of VertexAttribute named kAttributes, ordered by offset.
+ * @see BIG2_VERTEX_LAYOUT
+ */
+template<typename TVertex>
+struct VertexLayoutTraits;
+
+template<typename TVertex>
+concept VertexType = std::is_standard_layout_v<TVertex> && requires { VertexLayoutTraits<TVertex>::kAttributes; };
+
+namespace detail {
+
+[[nodiscard]] constexpr std::size_t GetAttributeSize(const VertexAttribute &attribute) {
+  switch (attribute.type) {
+    case bgfx::AttribType::Uint8: return attribute.count;
+    // Three or four components packed into 32 bits
+    case bgfx::AttribType::Uint10: return 4;
+    case bgfx::AttribType::Int16:
+    case bgfx::AttribType::Half: return attribute.count * 2u;
+    case bgfx::AttribType::Float: return attribute.count * 4u;
+    default: return 0;
+  }
+}
+
+template<std::size_t N>
+[[nodiscard]] constexpr bool HaveMemberSizes(const std::array<VertexAttribute, N> &attributes) {
+  for (const VertexAttribute &attribute : attributes) {
+    if (attribute.count < 1 || attribute.count > 4 || GetAttributeSize(attribute) != attribute.size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<std::size_t N>
+[[nodiscard]] constexpr bool AreOrderedWithoutOverlap(const std::array<VertexAttribute, N> &attributes) {
+  for (std::size_t i = 1; i < N; ++i) {
+    if (attributes[i].offset < attributes[i - 1].offset + attributes[i - 1].size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template<std::size_t N>
+[[nodiscard]] constexpr bool AreUnique(const std::array<VertexAttribute, N> &attributes) {
+  for (std::size_t i = 0; i < N; ++i) {
+    for (std::size_t j = i + 1; j < N; ++j) {
+      if (attributes[i].attribute == attributes[j].attribute) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Builds the layout, skipping the padding between members so the stride matches the struct.
+ */
+[[nodiscard]] bgfx::VertexLayout CreateVertexLayout(std::span<const VertexAttribute> attributes, std::size_t stride);
+
+/**
+ * @brief Creates a vertex layout handle that is destroyed together with BGFX by BgfxInitializationScoped.
+ */
+[[nodiscard]] bgfx::VertexLayoutHandle CreateCachedVertexLayoutHandle(const bgfx::VertexLayout &layout);
+
+/**
+ * @brief Changes whenever the cached vertex layout handles were destroyed.
+ */
+[[nodiscard]] std::uint32_t GetVertexLayoutHandlesGeneration();
+
+}
+
+/**
+ * @brief Destroys the handles made by GetVertexLayoutHandle(). BgfxInitializationScoped calls it before BGFX shuts down.
+ */
+void ReleaseVertexLayoutHandles();
+
+/**
+ * @brief Gets the layout of a vertex struct, built once on the first call.
+ * @details The sizes and offsets of the attributes are checked against the struct at compile time.
+ */
+template<VertexType TVertex>
+[[nodiscard]] const bgfx::VertexLayout &GetVertexLayout() {
+  constexpr auto &attributes = VertexLayoutTraits<TVertex>::kAttributes;
+  static_assert(detail::HaveMemberSizes(attributes), "Each attribute has to be as big as its member");
+  static_assert(detail::AreOrderedWithoutOverlap(attributes), "The attributes have to be ordered by offset and can't overlap");
+  static_assert(detail::AreUnique(attributes), "An attribute can only be used by one member");
+  static_assert(attributes.back().offset + attributes.back().size <= sizeof(TVertex), "The attributes don't fit in the vertex");
+
+  static const bgfx::VertexLayout layout = detail::CreateVertexLayout(attributes, sizeof(TVertex));
+  return layout;
+}
+
+/**
+ * @brief Gets a vertex layout handle for the struct, created on the first call and whenever BGFX was initialized again.
+ */
+template<VertexType TVertex>
+[[nodiscard]] bgfx::VertexLayoutHandle GetVertexLayoutHandle() {
+  static bgfx::VertexLayoutHandle handle = BGFX_INVALID_HANDLE;
+  static std::uint32_t generation = 0;
+
+  if (generation != detail::GetVertexLayoutHandlesGeneration()) {
+    handle = detail::CreateCachedVertexLayoutHandle(GetVertexLayout<TVertex>());
+    generation = detail::GetVertexLayoutHandlesGeneration();
+  }
+  return handle;
+}
+
+}
+
+/**
+ * @brief Describes a member of a vertex struct for BIG2_VERTEX_LAYOUT.
+ * @param TVertex The vertex struct
+ * @param member The name of the member
+ * @param attribute The bgfx::Attrib it is bound to
+ * @param count The number of components, 1 to 4
+ * @param type The bgfx::AttribType of each component
+ * @param normalized Whether integer components are mapped to 0..1 (or -1..1 for signed types)
+ */
+#define BIG2_VERTEX_ATTRIBUTE(TVertex, member, attribute, count, type, normalized) \
+  big2::VertexAttribute{attribute, count, type, normalized, offsetof(TVertex, member), sizeof(TVertex::member), false}
+
+/**
+ * @brief Declares the vertex layout of a struct, use it in the global namespace.
+ * @code
+ * struct ColorVertex {
+ *   glm::vec2 position;
+ *   std::uint32_t color;
+ * };
+ *
+ * BIG2_VERTEX_LAYOUT(ColorVertex,
+ *                    BIG2_VERTEX_ATTRIBUTE(ColorVertex, position, bgfx::Attrib::Position, 2, bgfx::AttribType::Float, false),
+ *                    BIG2_VERTEX_ATTRIBUTE(ColorVertex, color, bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true));
+ *
+ * bgfx::createVertexBuffer(memory, big2::GetVertexLayout<ColorVertex>());
+ * @endcode
+ */
+#define BIG2_VERTEX_LAYOUT(TVertex, ...) \
+  template<> \
+  struct big2::VertexLayoutTraits<TVertex> { \
+    static constexpr std::array kAttributes{__VA_ARGS__}; \
+  }
+
+#endif //BIG2_STACK_BGFX_VERTEX_LAYOUT_H_
@@ -13,6 +13,7 @@
 #include <optional>
 #include <GLFW/glfw3.h>
 #include <variant>
+#include <chrono>
 #include <big2/execution.h>
 
 namespace big2 {
@@ -123,6 +124,18 @@ gsl::span<GlfwEvent> GrabEvents(gsl::not_null<GLFWwindow *> window);
  */
 void PollEvents();
 
+/**
+ * @brief Same as PollEvents() but will put the thread to sleep until at least one event is available.
+ * @details Use this for on-demand render loops where nothing needs to happen without input.
+ */
+void WaitEvents();
+
+/**
+ * @brief Same as WaitEvents() but will wake up after the timeout even if no events are available.
+ * @param timeout The maximum time to wait for events
+ */
+void WaitEvents(std::chrono::nanoseconds timeout);
+
 /**
  * @brief Checks that the array of events has a certain event type.
  */
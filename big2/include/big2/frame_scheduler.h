@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_FRAME_SCHEDULER_H_
+#define BIG2_STACK_FRAME_SCHEDULER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace big2 {
+
+/**
+ * @brief A cooperative scheduler for work that doesn't need to happen on a particular frame.
+ * @details Work items are executed in priority order for as long as their cost fits in the budget given to Execute().
+ * The cost of each named work item is learned over time from its actual run time, so the estimate passed on enqueue
+ * is only used until the item has been measured at least once.
+ * Items that keep getting deferred are eventually forced to run so that nothing starves.
+ * @note This class is not thread-safe and is meant to be used from the main thread.
+ */
+class FrameScheduler final {
+ public:
+  using clock = std::chrono::steady_clock;
+  using duration = clock::duration;
+
+  enum class Priority : std::uint8_t {
+    Low,
+    Normal,
+    High,
+  };
+
+  /**
+   * @brief Adds a deferrable work item to the queue.
+   * @param name Identifies the kind of work. Items with the same name share their learned cost.
+   * @param work The work to be executed.
+   * @param priority Items with higher priority are considered first.
+   * @param estimated_cost Initial guess of the cost until the real cost is measured.
+   */
+  void Enqueue(std::string_view name, std::function<void()> work, Priority priority = Priority::Normal, duration estimated_cost = std::chrono::microseconds(500));
+
+  /**
+   * @brief Executes as many queued items as fit in the given budget.
+   * @details Items enqueued while executing will be considered on the next call.
+   * @param budget The time that can be spent on deferrable work.
+   * @return The number of items that were executed.
+   */
+  std::size_t Execute(duration budget);
+
+  /**
+   * @brief Gets the expected cost for the given kind of work.
+   * @return The learned cost or zero if this kind of work was never measured.
+   */
+  [[nodiscard]] duration GetLearnedCost(std::string_view name) const;
+
+  /**
+   * @brief Sets after how many frames of being deferred an item will run regardless of the budget.
+   */
+  void SetMaxDeferredFrames(std::uint32_t frames) { max_deferred_frames_ = frames; }
+  [[nodiscard]] std::uint32_t GetMaxDeferredFrames() const { return max_deferred_frames_; }
+
+  [[nodiscard]] std::size_t GetPendingCount() const { return items_.size(); }
+  [[nodiscard]] bool HasPendingWork() const { return !items_.empty(); }
+
+ private:
+  struct Item {
+    std::string name;
+    std::function<void()> work;
+    Priority priority = Priority::Normal;
+    duration estimated_cost = duration::zero();
+    std::uint64_t sequence = 0;
+    std::uint32_t deferred_frames = 0;
+  };
+
+  [[nodiscard]] duration GetExpectedCost(const Item &item) const;
+  void LearnCost(const std::string &name, duration measured_cost);
+
+  std::vector<Item> items_;
+  std::unordered_map<std::string, duration> learned_costs_;
+  std::uint64_t next_sequence_ = 0;
+  std::uint32_t max_deferred_frames_ = 120;
+};
+
+}
+
+#endif //BIG2_STACK_FRAME_SCHEDULER_H_
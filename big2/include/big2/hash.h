@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_HASH_H_
+#define BIG2_STACK_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace big2 {
+
+inline constexpr std::uint64_t kHashNameSeed = 14695981039346656037ull;
+
+/**
+ * @brief Hashes a name with 64-bit FNV-1a. Use it in constant expressions to get the hash at compile time.
+ * @param seed The hash of a prefix, so that HashName(b, HashName(a)) equals the hash of a followed by b.
+ */
+[[nodiscard]] constexpr std::uint64_t HashName(std::string_view name, std::uint64_t seed = kHashNameSeed) {
+  std::uint64_t hash = seed;
+  for (const char character : name) {
+    hash ^= static_cast<std::uint8_t>(character);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+/**
+ * @brief Hashes a block of memory quickly, meant for detecting changes in large buffers.
+ * @details The input is consumed 32 bytes at a time by four independent lanes, so the multiplications of a block
+ * don't wait on each other and the compiler can vectorize them. The hash isn't the same on every platform, don't store it.
+ * @param seed The hash of the previous block to hash several blocks as one.
+ */
+[[nodiscard]] std::uint64_t HashBytes(std::span<const std::byte> bytes, std::uint64_t seed = kHashNameSeed);
+
+/**
+ * @brief A name that is hashed at compile time when it is made from a string literal.
+ */
+struct HashedName final {
+  template<std::size_t N>
+  consteval explicit(false) HashedName(const char (&name)[N]) : hash(HashName(std::string_view(name, N - 1))) {}
+  constexpr explicit HashedName(std::uint64_t value) : hash(value) {}
+
+  std::uint64_t hash;
+
+  friend constexpr bool operator==(HashedName, HashedName) = default;
+};
+
+}
+
+#endif //BIG2_STACK_HASH_H_
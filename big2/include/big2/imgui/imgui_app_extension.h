@@ -8,7 +8,7 @@
 
 #if BIG2_IMGUI_ENABLED
 
-#include <vector>
+#include <unordered_map>
 #include <big2/app_extension_base.h>
 #include <big2/imgui/imgui_context_wrapper.h>
 
@@ -27,7 +27,7 @@ class ImGuiAppExtension final : public AppExtensionBase {
   void OnUpdate(std::float_t dt) override;
 
  private:
-  std::vector<ImGuiContextWrapper> contexts_;
+  std::unordered_map<GLFWwindow *, ImGuiContextWrapper> contexts_;
 };
 
 }
@@ -0,0 +1,99 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_MAIN_THREAD_QUEUE_H_
+#define BIG2_STACK_MAIN_THREAD_QUEUE_H_
+
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <future>
+#include <type_traits>
+#include <utility>
+
+namespace big2 {
+
+/**
+ * @brief A lock-free multiple-producer single-consumer queue of commands that have to be executed on the main thread.
+ * @details GLFW requires most window operations to happen on the main thread. Worker threads can post closures
+ * or typed commands (any object with a call operator) here and the main thread will run them when calling Drain().
+ * Posting a command also wakes up the main thread in case it is waiting for events.
+ * @code
+ * app.GetMainThreadQueue().Post([window = window.GetWindowHandle()]() { glfwSetWindowTitle(window, "Loaded"); });
+ * std::future<bool> resizable = app.GetMainThreadQueue().Invoke([&window]() { return window.GetIsResizable(); });
+ * @endcode
+ */
+class MainThreadQueue final {
+ public:
+  MainThreadQueue();
+  MainThreadQueue(MainThreadQueue &&) = delete;
+  MainThreadQueue &operator=(MainThreadQueue &&) = delete;
+  MainThreadQueue(const MainThreadQueue &) = delete;
+  MainThreadQueue &operator=(const MainThreadQueue &) = delete;
+  ~MainThreadQueue();
+
+  /**
+   * @brief Queues a command to be executed on the main thread. Can be called from any thread.
+   */
+  template<std::invocable TCommand>
+  void Post(TCommand &&command) {
+    Push(new CommandNode<std::decay_t<TCommand> >(std::forward<TCommand>(command)));
+  }
+
+  /**
+   * @brief Queues a command to be executed on the main thread and gives back a future for its result.
+   * @details Don't wait on the future from the main thread since this will block the queue from being drained.
+   */
+  template<std::invocable TCommand>
+  [[nodiscard]] std::future<std::invoke_result_t<TCommand> > Invoke(TCommand &&command) {
+    std::packaged_task<std::invoke_result_t<TCommand>()> task(std::forward<TCommand>(command));
+    std::future<std::invoke_result_t<TCommand> > result = task.get_future();
+    Post(std::move(task));
+    return result;
+  }
+
+  /**
+   * @brief Executes all queued commands. Should only be called by the main thread.
+   * @return The number of executed commands.
+   */
+  std::size_t Drain();
+
+  /**
+   * @brief Checks if there are commands waiting to be executed. Can be called from any thread.
+   * @details The result is only a hint if other threads are posting or draining at the same time.
+   */
+  [[nodiscard]] bool HasPendingCommands() const;
+
+ private:
+  struct Node {
+    virtual ~Node() = default;
+    virtual void Run() {}
+
+    std::atomic<Node *> next = nullptr;
+  };
+
+  template<typename TCommand>
+  struct CommandNode final : Node {
+    explicit CommandNode(TCommand &&value) : command(std::move(value)) {}
+    explicit CommandNode(const TCommand &value) : command(value) {}
+    void Run() override { command(); }
+
+    TCommand command;
+  };
+
+  void Push(Node *node);
+  void PushStub(Node *node);
+  [[nodiscard]] Node *Pop();
+
+  Node stub_;
+  std::atomic<Node *> head_;
+  Node *tail_;
+  // Counted apart from the nodes since only the main thread may touch the tail
+  std::atomic<std::size_t> pending_count_ = 0;
+};
+
+}
+
+#endif //BIG2_STACK_MAIN_THREAD_QUEUE_H_
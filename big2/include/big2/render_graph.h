@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_RENDER_GRAPH_H_
+#define BIG2_STACK_RENDER_GRAPH_H_
+
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+#include <big2/window.h>
+#include <big2/bgfx/bgfx_render_target_pool.h>
+
+namespace big2 {
+
+struct RenderGraphResource final {
+  static constexpr std::uint32_t kInvalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+  std::uint32_t index = kInvalidIndex;
+
+  [[nodiscard]] bool IsValid() const { return index != kInvalidIndex; }
+};
+
+struct RenderPassClear final {
+  std::uint16_t flags = BGFX_CLEAR_NONE;
+  std::uint32_t rgba = 0x000000FF;
+  std::float_t depth = 1.0f;
+  std::uint8_t stencil = 0;
+};
+
+class RenderGraph;
+
+/**
+ * @brief What a pass gets when it is executed.
+ */
+class RenderPassContext final {
+ public:
+  /**
+   * @brief The view that the pass should submit to. It is already bound to the pass output.
+   */
+  [[nodiscard]] bgfx::ViewId GetView() const { return view_id_; }
+  [[nodiscard]] glm::u16vec2 GetSize() const { return size_; }
+
+  /**
+   * @brief Gets the color texture of a transient target that the pass declared as an input.
+   */
+  [[nodiscard]] bgfx::TextureHandle GetTexture(RenderGraphResource resource) const;
+
+ private:
+  friend class RenderGraph;
+
+  RenderPassContext(const RenderGraph &graph, bgfx::ViewId view_id, glm::u16vec2 size) : graph_(graph), view_id_(view_id), size_(size) {}
+
+  const RenderGraph &graph_;
+  bgfx::ViewId view_id_;
+  glm::u16vec2 size_;
+};
+
+/**
+ * @brief Builds the passes of a frame and wires them to BGFX views and render targets.
+ * @details Passes declare which resources they read and which one they write. On Execute() the graph
+ * drops the passes that don't contribute to a window, assigns a view to every remaining pass and orders
+ * the views in the pass order before the window views. Transient targets are taken from the render target pool
+ * only for the passes between their first and last use, so targets with equal descriptors and lifetimes that don't
+ * overlap share the same memory. Targets read by passes that write to a window are kept until Execute() returns.
+ * Passes are executed in the order they were added.
+ * @code
+ * RenderGraphResource scene = {};
+ * graph.AddPass("Scene", [&](RenderGraph::PassBuilder &builder) {
+ *   scene = builder.CreateTarget("Scene", {.size = size, .depth_format = bgfx::TextureFormat::D24S8});
+ *   builder.Write(scene);
+ *   builder.SetClear({.flags = BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH});
+ * }, [&](const RenderPassContext &context) { DrawScene(context.GetView()); });
+ * graph.AddPass("Present", [&](RenderGraph::PassBuilder &builder) {
+ *   builder.Read(scene);
+ *   builder.Write(graph.ImportWindow(window));
+ * }, [&](const RenderPassContext &context) { DrawFullscreen(context.GetView(), context.GetTexture(scene)); });
+ * graph.Execute();
+ * @endcode
+ */
+class RenderGraph final {
+ public:
+  class PassBuilder final {
+   public:
+    /**
+     * @brief Declares a transient render target that lives only for this frame.
+     */
+    RenderGraphResource CreateTarget(std::string name, const RenderTargetDescriptor &descriptor);
+
+    void Read(RenderGraphResource resource);
+
+    /**
+     * @brief Sets the resource that the pass renders to. A pass has a single output.
+     */
+    void Write(RenderGraphResource resource);
+
+    /**
+     * @brief Sets the clear of the pass view.
+     * @details Offscreen passes don't clear by default. The first pass that writes to a window keeps the clear of the window view.
+     */
+    void SetClear(const RenderPassClear &clear);
+
+    /**
+     * @brief Keeps the pass even if its output doesn't reach a window, e.g. for readbacks.
+     */
+    void SetHasSideEffects();
+
+   private:
+    friend class RenderGraph;
+
+    PassBuilder(RenderGraph &graph, std::uint32_t pass_index) : graph_(graph), pass_index_(pass_index) {}
+
+    RenderGraph &graph_;
+    std::uint32_t pass_index_;
+  };
+
+  using SetupFunction = std::function<void(PassBuilder &)>;
+  using ExecuteFunction = std::function<void(const RenderPassContext &)>;
+
+  RenderGraph() = default;
+  explicit RenderGraph(BgfxRenderTargetPool &pool) : pool_(&pool) {}
+  RenderGraph(RenderGraph &&) = default;
+  RenderGraph &operator=(RenderGraph &&) = default;
+  RenderGraph(const RenderGraph &) = delete;
+  RenderGraph &operator=(const RenderGraph &) = delete;
+  ~RenderGraph();
+
+  /**
+   * @brief Makes the window a sink of the graph. Passes writing to it are never culled unless the window isn't renderable.
+   * @details The first pass that writes to the window renders to Window::GetView(), so whatever else renders
+   * to that view (like ImGui) is drawn on top of it.
+   */
+  RenderGraphResource ImportWindow(const Window &window);
+
+  void AddPass(std::string name, const SetupFunction &setup, ExecuteFunction execute);
+
+  /**
+   * @brief Culls, allocates and executes the passes, then clears the graph for the next frame.
+   * @details Call this every frame before the frame is submitted with big2::Frame(). Only one graph can be executed
+   * per frame, since the graph sets the order of every view and its targets go back to the pool when it returns,
+   * while the window views that read them are still to be drawn. Executing another graph in the same frame fails validation.
+   * @return The number of passes that were executed.
+   */
+  std::size_t Execute();
+
+  [[nodiscard]] std::size_t GetPassCount() const { return passes_.size(); }
+
+ private:
+  friend class RenderPassContext;
+
+  struct Resource {
+    std::string name;
+    RenderTargetDescriptor descriptor;
+    bool is_window = false;
+    bool is_presentable = false;
+    bgfx::ViewId window_view = 0;
+    bgfx::FrameBufferHandle window_frame_buffer = BGFX_INVALID_HANDLE;
+    PooledRenderTarget target;
+    std::uint32_t last_use = 0;
+    // Window views are ordered after all offscreen views, so these targets are only released when the frame is set up
+    bool is_read_by_window_pass = false;
+  };
+
+  struct Pass {
+    std::string name;
+    std::vector<std::uint32_t> reads;
+    std::uint32_t write = RenderGraphResource::kInvalidIndex;
+    std::optional<RenderPassClear> clear;
+    bool has_side_effects = false;
+    bool is_alive = false;
+    ExecuteFunction execute;
+  };
+
+  struct PassView {
+    bgfx::ViewId view_id = 0;
+    bool is_window_view = false;
+    bgfx::ViewId window_view = 0;
+  };
+
+  void CullPasses();
+  std::vector<PassView> AssignViews();
+  void OrderViews(const std::vector<PassView> &views);
+  [[nodiscard]] bgfx::ViewId GetReservedView(std::size_t index);
+  [[nodiscard]] BgfxRenderTargetPool &GetPool() const;
+
+  BgfxRenderTargetPool *pool_ = nullptr;
+  std::vector<Resource> resources_;
+  std::vector<Pass> passes_;
+  std::vector<bgfx::ViewId> reserved_views_;
+};
+
+}
+
+#endif //BIG2_STACK_RENDER_GRAPH_H_
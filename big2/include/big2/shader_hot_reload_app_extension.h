@@ -0,0 +1,43 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_SHADER_HOT_RELOAD_APP_EXTENSION_H_
+#define BIG2_STACK_SHADER_HOT_RELOAD_APP_EXTENSION_H_
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <big2/app_extension_base.h>
+#include <big2/shader_hot_reloader.h>
+
+namespace big2 {
+
+/**
+ * @brief Reloads changed shaders while the app runs. Meant for development builds.
+ * @details The compiled shaders are swapped in at the beginning of a frame, before anything is rendered.
+ * BIG2's own shaders are always watched when BIG2 is built with BIG2_SHADER_HOT_RELOAD.
+ * @code
+ * app.AddExtension<big2::ShaderHotReloadAppExtension>(std::vector<std::filesystem::path>{"path/to/shaders"});
+ * @endcode
+ * @see ShaderHotReloader
+ */
+class ShaderHotReloadAppExtension final : public AppExtensionBase {
+ public:
+  ShaderHotReloadAppExtension() = default;
+  explicit ShaderHotReloadAppExtension(std::vector<std::filesystem::path> directories) : directories_(std::move(directories)) {}
+
+ protected:
+  void OnInitialize() override;
+  void OnTerminate() override;
+  void OnFrameBegin() override;
+
+ private:
+  std::vector<std::filesystem::path> directories_;
+  std::unique_ptr<ShaderHotReloader> reloader_;
+};
+
+}
+
+#endif //BIG2_STACK_SHADER_HOT_RELOAD_APP_EXTENSION_H_
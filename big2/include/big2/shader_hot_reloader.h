@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_SHADER_HOT_RELOADER_H_
+#define BIG2_STACK_SHADER_HOT_RELOADER_H_
+
+#include <bgfx/bgfx.h>
+#include <big2/bgfx/bgfx_program_registry.h>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace big2 {
+
+struct ShaderCompilerSettings {
+  /// The shaderc executable that BGFX builds.
+  std::filesystem::path shaderc_path;
+  /// Additional include directories, usually the one with bgfx_shader.sh.
+  std::vector<std::filesystem::path> include_directories;
+};
+
+/**
+ * @brief Gets the shaderc and BGFX include paths of the build, empty if BIG2 was built without BIG2_SHADER_HOT_RELOAD.
+ */
+[[nodiscard]] ShaderCompilerSettings GetDefaultShaderCompilerSettings();
+
+/**
+ * @brief Gets the directory with the shader sources of BIG2 itself, empty if BIG2 was built without BIG2_SHADER_HOT_RELOAD.
+ */
+[[nodiscard]] std::filesystem::path GetBig2ShadersDirectory();
+
+/**
+ * @brief A development tool that recompiles shader sources when they change and swaps them into the program registry.
+ * @details The watched directories are laid out like the ones given to add_shaders_directory() in CMake: vs_*.sc and fs_*.sc
+ * files next to a varying.def.sc. Changes are picked up with inotify on Linux and by polling the modification times elsewhere.
+ * Changed shaders are compiled with shaderc for the current renderer only, on a worker thread that applies the
+ * ThreadRole::Worker configuration, so rendering never waits for the compiler.
+ * Compiled shaders are applied by ApplyCompiledShaders() which has to be called between frames.
+ * The reloader is also the ShaderVariantCompiler while it exists, variants are recompiled when their source changes too.
+ * @see ShaderHotReloadAppExtension
+ * @see ReplaceShaderBinary()
+ */
+class ShaderHotReloader final {
+ public:
+  explicit ShaderHotReloader(ShaderCompilerSettings settings = GetDefaultShaderCompilerSettings());
+  ShaderHotReloader(ShaderHotReloader &&) = delete;
+  ShaderHotReloader &operator=(ShaderHotReloader &&) = delete;
+  ShaderHotReloader(const ShaderHotReloader &) = delete;
+  ShaderHotReloader &operator=(const ShaderHotReloader &) = delete;
+  ~ShaderHotReloader();
+
+  /**
+   * @brief Starts watching the shader sources in the directory. Can be called from any thread.
+   */
+  void WatchDirectory(std::filesystem::path directory);
+
+  /**
+   * @brief Swaps the shaders that finished compiling into the program registry and reports compile errors.
+   * @return The number of shaders that were replaced.
+   */
+  std::size_t ApplyCompiledShaders();
+
+ private:
+  struct CompiledShader {
+    std::string name;
+    std::filesystem::path source;
+    std::vector<std::uint8_t> binary;
+    std::string errors;
+  };
+
+  void Run(const std::stop_token &stop_token);
+  [[nodiscard]] CompiledShader Compile(const ShaderVariantRequest &request) const;
+
+  ShaderCompilerSettings settings_;
+  std::string platform_;
+  std::string profile_;
+
+  std::mutex mutex_;
+  std::vector<std::filesystem::path> new_directories_;
+  std::vector<ShaderVariantRequest> new_variant_requests_;
+  std::vector<CompiledShader> compiled_shaders_;
+
+  // Declared last so the thread is stopped before anything it uses is destroyed
+  std::jthread worker_;
+};
+
+}
+
+#endif //BIG2_STACK_SHADER_HOT_RELOADER_H_
@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_SLOT_MAP_H_
+#define BIG2_STACK_SLOT_MAP_H_
+
+#include <gsl/gsl>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace big2 {
+
+/**
+ * @brief A stable reference to a value stored in a SlotMap.
+ * @details The generation makes sure that a handle to an erased value won't resolve to a value
+ * that was later stored in the same slot.
+ * @tparam TTag Makes handles of different maps incompatible with each other.
+ */
+template<typename TTag>
+struct SlotHandle final {
+  static constexpr std::uint32_t kInvalidIndex = std::numeric_limits<std::uint32_t>::max();
+
+  std::uint32_t index = kInvalidIndex;
+  std::uint32_t generation = 0;
+
+  [[nodiscard]] bool IsValid() const { return index != kInvalidIndex; }
+
+  friend bool operator==(const SlotHandle &, const SlotHandle &) = default;
+};
+
+/**
+ * @brief A container with O(1) insertion, removal and lookup by handle that keeps its values densely packed.
+ * @details Values are stored in a contiguous array so iterating over them is as fast as iterating a vector.
+ * Removing a value moves the last value in its place so references and iterators are invalidated by insertion and removal,
+ * but handles stay valid until the value they point to is removed.
+ */
+template<typename T, typename TTag = T>
+class SlotMap final {
+ public:
+  using handle_type = SlotHandle<TTag>;
+  using iterator = typename std::vector<T>::iterator;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  template<typename... TArgs>
+  handle_type Emplace(TArgs &&... args) {
+    std::uint32_t slot_index;
+    if (free_head_ != handle_type::kInvalidIndex) {
+      slot_index = free_head_;
+      free_head_ = slots_[slot_index].dense_index;
+    } else {
+      slot_index = gsl::narrow_cast<std::uint32_t>(slots_.size());
+      slots_.push_back({});
+    }
+
+    Slot &slot = slots_[slot_index];
+    slot.dense_index = gsl::narrow_cast<std::uint32_t>(values_.size());
+    values_.emplace_back(std::forward<TArgs>(args)...);
+    value_slots_.push_back(slot_index);
+
+    return {.index = slot_index, .generation = slot.generation};
+  }
+
+  bool Erase(handle_type handle) {
+    if (!Contains(handle)) {
+      return false;
+    }
+
+    Slot &slot = slots_[handle.index];
+    const std::uint32_t dense_index = slot.dense_index;
+    const std::uint32_t last_index = gsl::narrow_cast<std::uint32_t>(values_.size() - 1);
+
+    if (dense_index != last_index) {
+      values_[dense_index] = std::move(values_[last_index]);
+      value_slots_[dense_index] = value_slots_[last_index];
+      slots_[value_slots_[dense_index]].dense_index = dense_index;
+    }
+
+    values_.pop_back();
+    value_slots_.pop_back();
+
+    slot.generation++;
+    slot.dense_index = free_head_;
+    free_head_ = handle.index;
+    return true;
+  }
+
+  [[nodiscard]] bool Contains(handle_type handle) const {
+    return handle.index < slots_.size() && slots_[handle.index].generation == handle.generation
+        && slots_[handle.index].dense_index < values_.size() && value_slots_[slots_[handle.index].dense_index] == handle.index;
+  }
+
+  [[nodiscard]] T *Get(handle_type handle) {
+    return Contains(handle) ? &values_[slots_[handle.index].dense_index] : nullptr;
+  }
+
+  [[nodiscard]] const T *Get(handle_type handle) const {
+    return Contains(handle) ? &values_[slots_[handle.index].dense_index] : nullptr;
+  }
+
+  /**
+   * @brief Gets the handle of a value by its position in the dense array.
+   */
+  [[nodiscard]] handle_type GetHandleAt(std::size_t dense_index) const {
+    const std::uint32_t slot_index = value_slots_.at(dense_index);
+    return {.index = slot_index, .generation = slots_[slot_index].generation};
+  }
+
+  [[nodiscard]] gsl::span<T> GetValues() { return values_; }
+  [[nodiscard]] gsl::span<const T> GetValues() const { return values_; }
+
+  [[nodiscard]] std::size_t size() const { return values_.size(); }
+  [[nodiscard]] bool empty() const { return values_.empty(); }
+  iterator begin() { return values_.begin(); }
+  iterator end() { return values_.end(); }
+  const_iterator begin() const { return values_.begin(); }
+  const_iterator end() const { return values_.end(); }
+
+ private:
+  struct Slot {
+    // Points into the dense array while the slot is used and to the next free slot otherwise
+    std::uint32_t dense_index = handle_type::kInvalidIndex;
+    std::uint32_t generation = 0;
+  };
+
+  std::vector<Slot> slots_;
+  std::vector<T> values_;
+  std::vector<std::uint32_t> value_slots_;
+  std::uint32_t free_head_ = handle_type::kInvalidIndex;
+};
+
+}
+
+#endif //BIG2_STACK_SLOT_MAP_H_
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_THREAD_CONFIGURATION_H_
+#define BIG2_STACK_THREAD_CONFIGURATION_H_
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace big2 {
+
+/**
+ * @brief The kinds of threads that BIG2 runs or creates.
+ */
+enum class ThreadRole : std::uint8_t {
+  /// The thread that calls App::Run()
+  Main,
+  /// The render thread that BGFX creates on initialization
+  Render,
+  /// Any background thread created by BIG2
+  Worker,
+};
+
+enum class ThreadSchedulingPolicy : std::uint8_t {
+  /// Leaves the scheduling policy as it is (SCHED_OTHER on Linux)
+  Default,
+  /// SCHED_BATCH on Linux
+  Batch,
+  /// SCHED_IDLE on Linux
+  Idle,
+  /// SCHED_FIFO on Linux, usually requires elevated privileges
+  Fifo,
+  /// SCHED_RR on Linux, usually requires elevated privileges
+  RoundRobin,
+};
+
+struct ThreadConfiguration {
+  /// Name visible in debuggers and tools like top. Linux limits it to 15 characters.
+  std::string name;
+  /// Indices of the CPUs the thread is allowed to run on. Empty means no pinning.
+  std::vector<std::uint32_t> cpu_affinity;
+  ThreadSchedulingPolicy policy = ThreadSchedulingPolicy::Default;
+  /// Nice value for Default, Batch and Idle policies or the real-time priority for Fifo and RoundRobin.
+  std::int32_t priority = 0;
+};
+
+struct ThreadCpuTime {
+  ThreadRole role;
+  std::string name;
+  std::chrono::nanoseconds cpu_time;
+};
+
+/**
+ * @brief Sets the configuration for a role that will be used when the thread starts or when the app runs.
+ * @details Threads that are already running are not affected until ApplyThreadConfiguration() is called on them.
+ */
+void SetThreadConfiguration(ThreadRole role, ThreadConfiguration configuration);
+
+/**
+ * @brief Gets the configuration that was set for the role, if any.
+ */
+[[nodiscard]] std::optional<ThreadConfiguration> GetThreadConfiguration(ThreadRole role);
+
+/**
+ * @brief Applies the configuration of the role on the calling thread and registers it for CPU time reporting.
+ * @details BIG2 calls this on its own threads. Call it yourself only if you want to report on other threads.
+ * @return False if the configuration couldn't be fully applied. Failures are also logged as warnings.
+ */
+bool ApplyThreadConfiguration(ThreadRole role);
+
+/**
+ * @brief Finds the render thread that BGFX started and applies the Render role configuration to it.
+ * @details Does nothing if BGFX is running in single-threaded mode.
+ * @return False if the configuration couldn't be fully applied.
+ */
+bool ApplyRenderThreadConfiguration();
+
+/**
+ * @brief Reports how much CPU time each thread registered by BIG2 has consumed so far.
+ * @details Use this to verify that the pinning and priorities are giving the expected placement.
+ * Only supported on Linux, on other platforms the result is empty.
+ */
+[[nodiscard]] std::vector<ThreadCpuTime> GetThreadCpuTimes();
+
+}
+
+#endif //BIG2_STACK_THREAD_CONFIGURATION_H_
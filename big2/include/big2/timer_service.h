@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+
+#ifndef BIG2_STACK_TIMER_SERVICE_H_
+#define BIG2_STACK_TIMER_SERVICE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace big2 {
+
+/**
+ * @brief Keeps one-shot and repeating timers in a min-heap ordered by their deadline.
+ * @details Instead of every extension accumulating the delta time by itself the timers are all checked
+ * with a single comparison per frame and the next deadline can be used to know when to wake up.
+ * Timers can be added and cancelled from inside the callbacks.
+ * @note This class is not thread-safe and is meant to be used from the main thread.
+ */
+class TimerService final {
+ public:
+  using clock = std::chrono::steady_clock;
+  using duration = clock::duration;
+  using time_point = clock::time_point;
+  using TimerId = std::uint64_t;
+
+  /**
+   * @brief Calls the callback once after the delay has passed.
+   * @return An id that can be used to cancel the timer.
+   */
+  TimerId AddTimeout(duration delay, std::function<void()> callback);
+
+  /**
+   * @brief Calls the callback every time the period passes until cancelled.
+   * @details If dispatching falls behind by more than a period the missed calls are skipped instead of called in a burst.
+   * @return An id that can be used to cancel the timer.
+   */
+  TimerId AddInterval(duration period, std::function<void()> callback);
+
+  /**
+   * @brief Cancels a timer so that it won't be called anymore.
+   * @return False if the timer already finished or was cancelled.
+   */
+  bool Cancel(TimerId id);
+
+  /**
+   * @brief Calls all timers whose deadline has passed.
+   * @return The number of called timers.
+   */
+  std::size_t Dispatch(time_point now = clock::now());
+
+  /**
+   * @brief Gets the closest deadline of all active timers.
+   * @return The deadline or an empty optional if there are no active timers.
+   */
+  [[nodiscard]] std::optional<time_point> GetNextDeadline();
+
+  [[nodiscard]] bool IsActive(TimerId id) const { return timers_.contains(id); }
+  [[nodiscard]] std::size_t GetActiveCount() const { return timers_.size(); }
+
+ private:
+  struct Timer {
+    std::function<void()> callback;
+    duration period = duration::zero();
+    bool is_repeating = false;
+  };
+
+  struct Deadline {
+    time_point time;
+    TimerId id;
+  };
+
+  TimerId AddTimer(duration delay, duration period, bool is_repeating, std::function<void()> callback);
+  void PushDeadline(Deadline deadline);
+  void PopDeadline();
+  void DropCancelledDeadlines();
+
+  std::vector<Deadline> deadlines_;
+  std::unordered_map<TimerId, Timer> timers_;
+  TimerId next_id_ = 1;
+};
+
+}
+
+#endif //BIG2_STACK_TIMER_SERVICE_H_
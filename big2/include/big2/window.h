@@ -9,6 +9,8 @@
 #include <gsl/gsl>
 #include <glm/glm.hpp>
 #include <bgfx/bgfx.h>
+#include <chrono>
+#include <optional>
 
 struct GLFWwindow;
 struct GLFWmonitor;
@@ -23,6 +25,10 @@ namespace big2 {
  */
 class Window final {
  public:
+  using clock = std::chrono::steady_clock;
+
+  static constexpr std::chrono::seconds kDefaultFrameBufferReleaseDelay{5};
+
   explicit(false) Window(gsl::not_null<GLFWwindow *> window);
   Window(gsl::czstring title, glm::ivec2 size, GLFWmonitor *monitor = nullptr);
   Window(Window &&) = default;
@@ -39,6 +45,15 @@ class Window final {
   void SetWindowSize(glm::u16vec2 size);
   void Dispose();
 
+  /**
+   * @brief Creates the window frame buffer when the window is visible and releases it once it was hidden for long enough.
+   * @details Frame buffers are created lazily, so windows that are hidden or iconified don't use GPU memory.
+   * App calls this at the beginning of every frame. Call it yourself if you manage the window without an App.
+   * Windows sharing the single back buffer of the renderer don't have a frame buffer of their own.
+   * @param release_delay How long the window has to stay hidden or iconified before its frame buffer is released.
+   */
+  void UpdateFrameBuffer(clock::duration release_delay = kDefaultFrameBufferReleaseDelay);
+
   [[nodiscard]] gsl::not_null<GLFWwindow *> GetWindowHandle() const { return window_; }
   [[nodiscard]] bool GetIsScoped() const { return is_scoped_; }
   Window& SetIsScoped(bool scoped);
@@ -51,14 +66,29 @@ class Window final {
   [[nodiscard]] bool GetShouldClose() const;
   [[nodiscard]] glm::u16vec2 GetBackBufferSize() const;
 
+  /**
+   * @brief Checks if the window is shown, not iconified and has a non-zero size.
+   */
+  [[nodiscard]] bool GetIsVisible() const;
+
+  /**
+   * @brief Checks if anything submitted to the window view would be presented.
+   * @details This is false for visible windows until UpdateFrameBuffer() created their frame buffer.
+   * Renderers with a single swap chain only present the window bound by BgfxInitializationScoped::BindWindow().
+   */
+  [[nodiscard]] bool GetIsRenderable() const;
+
  private:
   void Initialize();
+  void CreateFrameBuffer();
+  void ReleaseFrameBuffer();
 
   gsl::owner<GLFWwindow *> window_ = nullptr;
   bgfx::FrameBufferHandle frame_buffer_ = BGFX_INVALID_HANDLE;
   bgfx::ViewId view_id_ = BGFX_INVALID_HANDLE;
   bool is_scoped_ = true;
   glm::u16vec2 back_buffer_size_ = {0, 0};
+  std::optional<clock::time_point> hidden_since_;
 };
 
 }
@@ -9,16 +9,17 @@
 #include <big2/glfw/glfw_utils.h>
 #include <big2/event_queue.h>
 #include <big2/bgfx/bgfx_utils.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
 #include <big2/execution.h>
 #include <chrono>
 
 namespace big2 {
-Window &App::AddWindow(const std::string &title, glm::ivec2 size) {
-  Expects(windows_.empty() || BgfxSupportsMultipleWindows());
-
+WindowHandle App::AddWindow(const std::string &title, glm::ivec2 size) {
   glfwWindowHint(GLFW_FLOATING, false);
-  Window window(title.c_str(), size);
+  WindowHandle handle = windows_.Emplace(title.c_str(), size);
+  Window &window = *windows_.Get(handle);
   window.SetIsScoped(false);
+  window_handles_.insert_or_assign(window.GetWindowHandle(), handle);
   big2::GlfwEventQueue::ConnectWindow(window);
 
   auto call_extensions_window_created = [&window](std::unique_ptr<AppExtensionBase> &extension) {
@@ -26,12 +27,29 @@ Window &App::AddWindow(const std::string &title, glm::ivec2 size) {
   };
 
   std::for_each(EXECUTION_POLICY(std::execution::seq) extensions_.begin(), extensions_.end(), call_extensions_window_created);
-  return windows_.emplace_back(window);
+  return handle;
+}
+
+WindowHandle App::FindWindowHandle(GLFWwindow *window_handle) const {
+  if (window_handle == nullptr) {
+    return {};
+  }
+
+  auto it = window_handles_.find(window_handle);
+  return it != window_handles_.end() ? it->second : WindowHandle{};
+}
+
+App &App::SetThreadConfiguration(ThreadRole role, ThreadConfiguration configuration) {
+  big2::SetThreadConfiguration(role, std::move(configuration));
+  return *this;
 }
 
 void App::Run() {
   state_ = ActiveState::Run;
 
+  big2::ApplyThreadConfiguration(ThreadRole::Main);
+  big2::ApplyRenderThreadConfiguration();
+
   std::for_each(EXECUTION_POLICY(std::execution::seq)
                 extensions_.begin(),
                 extensions_.end(),
@@ -53,12 +71,15 @@ void App::Run() {
 
   auto call_extensions_window_render = [this](std::unique_ptr<AppExtensionBase> &extension) {
     for (Window &window : windows_) {
-      extension->OnRender(window);
+      if (window.GetIsRenderable()) {
+        extension->OnRender(window);
+      }
     }
   };
 
   while (state_ != ActiveState::Stop) {
     MandatoryBeginFrame();
+    timers_.Dispatch();
 
     if (state_ != ActiveState::Pause) {
       std::for_each(EXECUTION_POLICY(std::execution::seq) extensions_.begin(), extensions_.end(), call_extensions_update);
@@ -68,11 +89,18 @@ void App::Run() {
       std::for_each(EXECUTION_POLICY(std::execution::seq) extensions_.begin(), extensions_.end(), call_extensions_frame_begin);
       std::for_each(EXECUTION_POLICY(std::execution::seq) extensions_.begin(), extensions_.end(), call_extensions_window_render);
       std::for_each(EXECUTION_POLICY(std::execution::seq) extensions_.begin(), extensions_.end(), call_extensions_frame_end);
-      bgfx::frame();
+      big2::Frame();
     }
 
     ProcessClosedWindows();
+    ExecuteDeferredWork();
+  }
+
+  // Windows that are still open are closed so their resources are released before BGFX is shut down
+  for (Window &window : windows_) {
+    glfwSetWindowShouldClose(window.GetWindowHandle(), GLFW_TRUE);
   }
+  ProcessClosedWindows();
 
   // Terminate
   std::for_each(EXECUTION_POLICY(std::execution::seq)
@@ -85,39 +113,83 @@ void App::Run() {
 
 void App::MandatoryBeginFrame() {
   do_render_this_frame_ = true;
+  main_thread_queue_->Drain();
+
+  if (wait_for_events_) {
+    WaitForEvents();
+  } else {
+    GlfwEventQueue::PollEvents();
+  }
   UpdateDeltaTime();
-  GlfwEventQueue::PollEvents();
 
   for (Window &window : windows_) {
-    if (big2::GlfwEventQueue::HasEventType<GlfwEvent::WindowResized>(window)
-        || window.GetBackBufferSize() != window.GetSize()) {
+    const bool is_visible = window.GetIsVisible();
+    if (is_visible && (big2::GlfwEventQueue::HasEventType<GlfwEvent::WindowResized>(window)
+        || window.GetBackBufferSize() != window.GetSize())) {
       window.SetFrameSize(window.GetSize());
       DoNotRenderThisFrame();
-      bgfx::frame();
+      big2::Frame();
     }
+
+    window.UpdateFrameBuffer(window_frame_buffer_release_delay_);
+  }
+}
+
+void App::WaitForEvents() {
+  if (scheduler_.HasPendingWork() || main_thread_queue_->HasPendingCommands()) {
+    GlfwEventQueue::PollEvents();
+    return;
+  }
+
+  std::optional<TimerService::time_point> next_deadline = timers_.GetNextDeadline();
+  if (next_deadline.has_value()) {
+    GlfwEventQueue::WaitEvents(next_deadline.value() - TimerService::clock::now());
+  } else {
+    GlfwEventQueue::WaitEvents();
+  }
+}
+
+void App::ExecuteDeferredWork() {
+  const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - previous_frame_time_;
+  if (elapsed < target_frame_time_) {
+    scheduler_.Execute(target_frame_time_ - elapsed);
+  } else {
+    scheduler_.Execute(std::chrono::nanoseconds::zero());
   }
 }
 
 void App::ProcessClosedWindows() {
-  for (Window &window : windows_) {
-    if (!window.GetShouldClose()) {
-      continue;
+  std::vector<WindowHandle> closed_windows;
+  for (std::size_t i = 0; i < windows_.size(); i++) {
+    if (windows_.GetValues()[i].GetShouldClose()) {
+      closed_windows.push_back(windows_.GetHandleAt(i));
     }
+  }
+
+  for (WindowHandle handle : closed_windows) {
+    Window &window = *windows_.Get(handle);
 
     auto call_window_destroy = [&window](std::unique_ptr<AppExtensionBase> &extension) {
       extension->OnWindowDestroyed(window);
     };
 
+    window_handles_.erase(window.GetWindowHandle());
     window.Dispose();
     std::for_each(extensions_.begin(), extensions_.end(), call_window_destroy);
+    windows_.Erase(handle);
   }
 
-  std::erase_if(windows_, [](Window &window) { return window.GetShouldClose(); });
+  // With a single swap chain the back buffer moves to one of the remaining windows
+  BgfxInitializationScoped *bgfx_initialization = BgfxInitializationScoped::GetInstance();
+  if (!closed_windows.empty() && !windows_.empty() && !BgfxSupportsMultipleWindows() && bgfx_initialization->GetBoundWindow() == nullptr) {
+    Window &window = windows_.GetValues()[0];
+    bgfx_initialization->BindWindow(window, window.GetBackBufferSize());
+  }
 }
 
-App::App(bgfx::RendererType::Enum renderer_type, std::uint64_t capabilities) {
+App::App(bgfx::RendererType::Enum renderer_type, std::uint64_t capabilities, std::filesystem::path transient_limits_file) {
   glfw_initialization_scoped_ = std::make_unique<GlfwInitializationScoped>();
-  bgfx_initialization_scoped_ = std::make_unique<BgfxInitializationScoped>(renderer_type, capabilities);
+  bgfx_initialization_scoped_ = std::make_unique<BgfxInitializationScoped>(renderer_type, capabilities, std::move(transient_limits_file));
   big2::GlfwEventQueue::Initialize();
 }
 
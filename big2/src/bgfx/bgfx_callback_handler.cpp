@@ -3,6 +3,7 @@
 // All rights reserved.
 //
 #include <big2/bgfx/bgfx_callback_handler.h>
+#include <big2/bgfx/bgfx_shader_cache.h>
 #include <spdlog/spdlog.h>
 
 void big2::BgfxCallbackHandler::fatal(const char *file_path, uint16_t line, bgfx::Fatal::Enum code, const char *message) {
@@ -26,15 +27,20 @@ void big2::BgfxCallbackHandler::profilerBeginLiteral(const char *, uint32_t, con
 void big2::BgfxCallbackHandler::profilerEnd() {
 }
 
-uint32_t big2::BgfxCallbackHandler::cacheReadSize(uint64_t) {
-  return 0;
+uint32_t big2::BgfxCallbackHandler::cacheReadSize(uint64_t id) {
+  BgfxShaderCache *cache = BgfxShaderCache::GetInstance();
+  return cache != nullptr ? cache->GetEntrySize(id) : 0;
 }
 
-bool big2::BgfxCallbackHandler::cacheRead(uint64_t, void *, uint32_t) {
-  return false;
+bool big2::BgfxCallbackHandler::cacheRead(uint64_t id, void *data, uint32_t size) {
+  BgfxShaderCache *cache = BgfxShaderCache::GetInstance();
+  return cache != nullptr && cache->Read(id, data, size);
 }
 
-void big2::BgfxCallbackHandler::cacheWrite(uint64_t, const void *, uint32_t) {
+void big2::BgfxCallbackHandler::cacheWrite(uint64_t id, const void *data, uint32_t size) {
+  if (BgfxShaderCache *cache = BgfxShaderCache::GetInstance(); cache != nullptr) {
+    cache->Write(id, data, size);
+  }
 }
 
 void big2::BgfxCallbackHandler::screenShot(const char *, uint32_t, uint32_t, uint32_t, const void *, uint32_t, bool) {
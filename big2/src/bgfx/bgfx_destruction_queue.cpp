@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_initialization_scoped.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/bgfx/bgfx_handle_registry.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace big2 {
+
+struct PendingRelease {
+  std::uint32_t frame;
+  BgfxHandleType type;
+  std::uint16_t index;
+  // Set only for fence actions, handles are destroyed by their type and index
+  std::function<void()> action;
+};
+
+static std::mutex release_mutex;
+// Ordered from the oldest frame so releases can be popped from the front
+static std::deque<PendingRelease> pending_releases;
+static std::uint32_t submitted_frame_count = 0;
+static std::uint32_t destruction_latency = 2;
+
+static void DestroyHandle(BgfxHandleType type, std::uint16_t index) {
+  detail::UntrackResource(ToResourceCategory(type), index);
+  detail::OnBgfxHandleDestroyed(type, index);
+
+  switch (type) {
+    case BgfxHandleType::DynamicIndexBuffer: bgfx::destroy(bgfx::DynamicIndexBufferHandle{index}); break;
+    case BgfxHandleType::DynamicVertexBuffer: bgfx::destroy(bgfx::DynamicVertexBufferHandle{index}); break;
+    case BgfxHandleType::FrameBuffer: bgfx::destroy(bgfx::FrameBufferHandle{index}); break;
+    case BgfxHandleType::IndexBuffer: bgfx::destroy(bgfx::IndexBufferHandle{index}); break;
+    case BgfxHandleType::IndirectBuffer: bgfx::destroy(bgfx::IndirectBufferHandle{index}); break;
+    case BgfxHandleType::OcclusionQuery: bgfx::destroy(bgfx::OcclusionQueryHandle{index}); break;
+    case BgfxHandleType::Program: bgfx::destroy(bgfx::ProgramHandle{index}); break;
+    case BgfxHandleType::Shader: bgfx::destroy(bgfx::ShaderHandle{index}); break;
+    case BgfxHandleType::Texture: bgfx::destroy(bgfx::TextureHandle{index}); break;
+    case BgfxHandleType::Uniform: bgfx::destroy(bgfx::UniformHandle{index}); break;
+    case BgfxHandleType::VertexBuffer: bgfx::destroy(bgfx::VertexBufferHandle{index}); break;
+    case BgfxHandleType::VertexLayout: bgfx::destroy(bgfx::VertexLayoutHandle{index}); break;
+    case BgfxHandleType::Count: break;
+  }
+}
+
+static void Execute(PendingRelease &release) {
+  if (release.action) {
+    release.action();
+  } else {
+    DestroyHandle(release.type, release.index);
+  }
+}
+
+static bool IsFrameDone(std::uint32_t frame) {
+  // Unsigned subtraction keeps working when the frame counter wraps around
+  return submitted_frame_count - frame >= destruction_latency;
+}
+
+static bool IsDeferringEnabled() {
+  return BgfxInitializationScoped::GetInstance() != nullptr;
+}
+
+static void Enqueue(PendingRelease release) {
+  std::unique_lock lock(release_mutex);
+  if (!IsDeferringEnabled() || IsFrameDone(release.frame)) {
+    lock.unlock();
+    Execute(release);
+    return;
+  }
+
+  auto position = std::upper_bound(pending_releases.begin(), pending_releases.end(), release.frame,
+                                   [](std::uint32_t frame, const PendingRelease &other) {
+                                     return submitted_frame_count - frame > submitted_frame_count - other.frame;
+                                   });
+  pending_releases.insert(position, std::move(release));
+}
+
+static std::vector<PendingRelease> TakeReleases(bool take_all) {
+  std::scoped_lock lock(release_mutex);
+  std::vector<PendingRelease> releases;
+  while (!pending_releases.empty() && (take_all || IsFrameDone(pending_releases.front().frame))) {
+    releases.push_back(std::move(pending_releases.front()));
+    pending_releases.pop_front();
+  }
+
+  return releases;
+}
+
+std::uint32_t Frame(bool capture) {
+  const std::uint32_t frame_number = bgfx::frame(capture);
+
+  {
+    std::scoped_lock lock(release_mutex);
+    submitted_frame_count++;
+  }
+
+  // Executed outside the lock since actions are allowed to release more resources
+  for (PendingRelease &release : TakeReleases(/* take_all= */ false)) {
+    Execute(release);
+  }
+
+  return frame_number;
+}
+
+std::uint32_t GetSubmittedFrameCount() {
+  std::scoped_lock lock(release_mutex);
+  return submitted_frame_count;
+}
+
+void SetDestructionLatency(std::uint32_t frames) {
+  std::scoped_lock lock(release_mutex);
+  destruction_latency = frames;
+}
+
+std::uint32_t GetDestructionLatency() {
+  std::scoped_lock lock(release_mutex);
+  return destruction_latency;
+}
+
+FrameFence InsertFrameFence() {
+  return {.frame = GetSubmittedFrameCount()};
+}
+
+bool IsFrameFenceSignaled(FrameFence fence) {
+  std::scoped_lock lock(release_mutex);
+  return IsFrameDone(fence.frame);
+}
+
+void ExecuteOnFrameFence(FrameFence fence, std::function<void()> action) {
+  Enqueue({.frame = fence.frame, .type = BgfxHandleType::Count, .index = 0, .action = std::move(action)});
+}
+
+void FlushDestructionQueue() {
+  std::vector<PendingRelease> releases = TakeReleases(/* take_all= */ true);
+  while (!releases.empty()) {
+    for (PendingRelease &release : releases) {
+      Execute(release);
+    }
+    releases = TakeReleases(/* take_all= */ true);
+  }
+}
+
+namespace detail {
+
+void DestroyDeferred(BgfxHandleType type, std::uint16_t index) {
+  Enqueue({.frame = GetSubmittedFrameCount(), .type = type, .index = index, .action = {}});
+}
+
+}
+
+}
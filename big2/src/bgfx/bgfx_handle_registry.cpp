@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_handle_registry.h>
+
+#if BIG2_CHECKED_HANDLES
+#include <array>
+#include <limits>
+#include <mutex>
+#include <vector>
+#endif // BIG2_CHECKED_HANDLES
+
+namespace big2 {
+
+#if BIG2_CHECKED_HANDLES
+
+struct HandleTable {
+  // Allocated on first use since most handle types are never used
+  std::vector<detail::BgfxHandleGeneration> generations;
+  std::uint32_t live_count = 0;
+};
+
+static std::mutex handle_tables_mutex;
+static std::array<HandleTable, static_cast<std::size_t>(BgfxHandleType::Count)> handle_tables;
+
+static HandleTable &GetHandleTable(BgfxHandleType type) {
+  HandleTable &table = handle_tables.at(static_cast<std::size_t>(type));
+  if (table.generations.empty()) {
+    table.generations.resize(std::numeric_limits<std::uint16_t>::max() + 1);
+  }
+  return table;
+}
+
+std::uint32_t GetLiveBgfxHandleCount(BgfxHandleType type) {
+  std::scoped_lock lock(handle_tables_mutex);
+  return handle_tables.at(static_cast<std::size_t>(type)).live_count;
+}
+
+namespace detail {
+
+BgfxHandleGeneration OnBgfxHandleAcquired(BgfxHandleType type, std::uint16_t index) {
+  std::scoped_lock lock(handle_tables_mutex);
+  HandleTable &table = GetHandleTable(type);
+  table.live_count++;
+  return table.generations[index];
+}
+
+void OnBgfxHandleReleased(BgfxHandleType type, std::uint16_t) {
+  std::scoped_lock lock(handle_tables_mutex);
+  HandleTable &table = GetHandleTable(type);
+  table.live_count--;
+}
+
+void OnBgfxHandleDestroyed(BgfxHandleType type, std::uint16_t index) {
+  std::scoped_lock lock(handle_tables_mutex);
+  GetHandleTable(type).generations[index]++;
+}
+
+BgfxHandleGeneration GetBgfxHandleGeneration(BgfxHandleType type, std::uint16_t index) {
+  std::scoped_lock lock(handle_tables_mutex);
+  return GetHandleTable(type).generations[index];
+}
+
+}
+
+#else
+
+std::uint32_t GetLiveBgfxHandleCount(BgfxHandleType) {
+  return 0;
+}
+
+namespace detail {
+
+BgfxHandleGeneration OnBgfxHandleAcquired(BgfxHandleType, std::uint16_t) {
+  return 0;
+}
+
+void OnBgfxHandleReleased(BgfxHandleType, std::uint16_t) {
+}
+
+void OnBgfxHandleDestroyed(BgfxHandleType, std::uint16_t) {
+}
+
+BgfxHandleGeneration GetBgfxHandleGeneration(BgfxHandleType, std::uint16_t) {
+  return 0;
+}
+
+}
+
+#endif // BIG2_CHECKED_HANDLES
+
+}
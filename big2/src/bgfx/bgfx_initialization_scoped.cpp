@@ -8,24 +8,50 @@
 #include <bgfx/bgfx.h>
 #include <big2/bgfx/bgfx_utils.h>
 #include <big2/bgfx/bgfx_callback_handler.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/bgfx/bgfx_vertex_layout.h>
+#include <big2/bgfx/bgfx_uniform_registry.h>
+#include <big2/bgfx/bgfx_program_registry.h>
 #include <bgfx/platform.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <limits>
+#include <utility>
+#include <big2/glfw/glfw_utils.h>
 
 namespace big2 {
+// The transient buffers grow in steps of this and keep a quarter of room above the high-water marks
+static constexpr std::uint32_t kTransientBufferGranularity = 1u << 20;
+static constexpr std::uint32_t kTransientLimitsMagic = 0x4C543242; // "B2TL"
+static constexpr std::uint32_t kTransientLimitsVersion = 1;
+
 static BgfxCallbackHandler global_bgfx_callback_handler;
 BgfxInitializationScoped *BgfxInitializationScoped::instance_ = nullptr;
 
-BgfxInitializationScoped::BgfxInitializationScoped(bgfx::RendererType::Enum renderer_type,  std::uint64_t capabilities)
+BgfxInitializationScoped::BgfxInitializationScoped(bgfx::RendererType::Enum renderer_type,  std::uint64_t capabilities, std::filesystem::path transient_limits_file)
   : renderer_type_(renderer_type)
-  , capabilities_(capabilities) {
+  , capabilities_(capabilities)
+  , transient_limits_file_(std::move(transient_limits_file)) {
   Expects(instance_ == nullptr);
   instance_ = this;
 
+  if (!transient_limits_file_.empty()) {
+    LoadTransientHighWaterMarks();
+    GrowTransientLimits();
+  }
+
   bgfx::Init init_object = bgfx::Init();
   init_object.callback = &global_bgfx_callback_handler;
   init_object.type = renderer_type;
   init_object.resolution.width = 0;
   init_object.resolution.height = 0;
   init_object.capabilities = capabilities_;
+  init_object.limits = limits_;
+  SetNativeDisplayData(platform_data_);
+  init_object.platformData = platform_data_;
 
   if (renderer_type == bgfx::RendererType::Vulkan) {
     big2::Validate(glfwVulkanSupported(), "Vulkan is not supported by GLFW");
@@ -34,22 +60,61 @@ BgfxInitializationScoped::BgfxInitializationScoped(bgfx::RendererType::Enum rend
   big2::Validate(bgfx::init(init_object), "BGFX couldn't be initialized");
 }
 
-BgfxInitializationScoped::BgfxInitializationScoped(BgfxInitializationScoped && other) : renderer_type_(std::move(other.renderer_type_)) {
+BgfxInitializationScoped::BgfxInitializationScoped(BgfxInitializationScoped && other)
+  : renderer_type_(std::move(other.renderer_type_))
+  , platform_data_(other.platform_data_)
+  , bound_window_(other.bound_window_)
+  , limits_(other.limits_)
+  , transient_limits_file_(std::move(other.transient_limits_file_))
+  , has_new_high_water_marks_(std::exchange(other.has_new_high_water_marks_, false))
+  , transient_vertex_high_water_mark_(other.transient_vertex_high_water_mark_)
+  , transient_index_high_water_mark_(other.transient_index_high_water_mark_) {
   instance_ = this;
 }
 
 BgfxInitializationScoped & BgfxInitializationScoped::operator=(BgfxInitializationScoped &&other) noexcept {
   instance_ = this;
   renderer_type_ = other.renderer_type_;
+  platform_data_ = other.platform_data_;
+  bound_window_ = other.bound_window_;
+  limits_ = other.limits_;
+  transient_limits_file_ = std::move(other.transient_limits_file_);
+  has_new_high_water_marks_ = std::exchange(other.has_new_high_water_marks_, false);
+  transient_vertex_high_water_mark_ = other.transient_vertex_high_water_mark_;
+  transient_index_high_water_mark_ = other.transient_index_high_water_mark_;
   return *this;
 }
 
 BgfxInitializationScoped::~BgfxInitializationScoped() {
+  if (has_new_high_water_marks_ && !transient_limits_file_.empty()) {
+    SaveTransientHighWaterMarks();
+  }
+
+  GetRenderTargetPool().Clear();
+  ReleaseVertexLayoutHandles();
+  ReleaseUniforms();
+  ReleasePrograms();
+  FlushDestructionQueue();
+  ReportResourceLeaks();
   bgfx::shutdown();
+  ClearTrackedResources();
+
+  // Releases after the shutdown mustn't be queued for frames that never come
+  if (instance_ == this) {
+    instance_ = nullptr;
+  }
 }
 
 void BgfxInitializationScoped::ReInitialize(gsl::not_null<GLFWwindow *> window, const glm::ivec2 size) {
+  GetRenderTargetPool().Clear();
+  ReleaseVertexLayoutHandles();
+  ReleaseUniforms();
+  ReleasePrograms();
+  FlushDestructionQueue();
+  ReportResourceLeaks();
   bgfx::shutdown();
+  ClearTrackedResources();
+  GrowTransientLimits();
 
   bgfx::Init init_object = bgfx::Init();
   init_object.callback = &global_bgfx_callback_handler;
@@ -57,8 +122,98 @@ void BgfxInitializationScoped::ReInitialize(gsl::not_null<GLFWwindow *> window,
   init_object.resolution.width = size.x;
   init_object.resolution.height = size.y;
   init_object.capabilities = capabilities_;
+  init_object.limits = limits_;
   big2::SetNativeWindowData(init_object, window);
+  platform_data_ = init_object.platformData;
+  bound_window_ = window;
 
   big2::Validate(bgfx::init(init_object), "BGFX couldn't be initialized");
 }
+
+void BgfxInitializationScoped::BindWindow(gsl::not_null<GLFWwindow *> window, const glm::ivec2 size) {
+  if (bound_window_ != window) {
+    platform_data_.nwh = GetNativeWindowHandle(window);
+    bgfx::setPlatformData(platform_data_);
+    bound_window_ = window;
+  }
+
+  bgfx::reset(size.x, size.y);
+}
+
+void BgfxInitializationScoped::UnbindWindow(gsl::not_null<GLFWwindow *> window) {
+  if (bound_window_ == window) {
+    bound_window_ = nullptr;
+  }
+}
+
+void BgfxInitializationScoped::RecordTransientBufferUse(std::uint32_t vertex_bytes, std::uint32_t index_bytes) {
+  if (const std::uint32_t frame = GetSubmittedFrameCount(); frame != transient_use_frame_) {
+    transient_use_frame_ = frame;
+    transient_vertex_bytes_ = 0;
+    transient_index_bytes_ = 0;
+  }
+
+  transient_vertex_bytes_ += vertex_bytes;
+  transient_index_bytes_ += index_bytes;
+  if (transient_vertex_bytes_ > transient_vertex_high_water_mark_ || transient_index_bytes_ > transient_index_high_water_mark_) {
+    transient_vertex_high_water_mark_ = std::max(transient_vertex_high_water_mark_, transient_vertex_bytes_);
+    transient_index_high_water_mark_ = std::max(transient_index_high_water_mark_, transient_index_bytes_);
+    has_new_high_water_marks_ = true;
+  }
+}
+
+void BgfxInitializationScoped::GrowTransientLimits() {
+  const auto get_size = [](std::uint32_t current_size, std::uint64_t high_water_mark) {
+    const std::uint64_t wanted_size = high_water_mark + high_water_mark / 4;
+    const std::uint64_t rounded_size = (wanted_size + kTransientBufferGranularity - 1) / kTransientBufferGranularity * kTransientBufferGranularity;
+    return gsl::narrow_cast<std::uint32_t>(std::clamp<std::uint64_t>(rounded_size, current_size, std::numeric_limits<std::uint32_t>::max()));
+  };
+
+  const std::uint32_t vertex_size = get_size(limits_.transientVbSize, transient_vertex_high_water_mark_);
+  const std::uint32_t index_size = get_size(limits_.transientIbSize, transient_index_high_water_mark_);
+  if (vertex_size != limits_.transientVbSize || index_size != limits_.transientIbSize) {
+    big2::Info(spdlog::fmt_lib::format("Growing the transient buffers to {} bytes of vertices and {} bytes of indices", vertex_size, index_size).c_str());
+    limits_.transientVbSize = vertex_size;
+    limits_.transientIbSize = index_size;
+  }
+}
+
+void BgfxInitializationScoped::LoadTransientHighWaterMarks() {
+  std::ifstream file(transient_limits_file_, std::ios::binary);
+  if (!file) {
+    return;
+  }
+
+  std::array<std::uint32_t, 4> values{};
+  file.read(reinterpret_cast<char *>(values.data()), sizeof(values));
+  if (!file || values[0] != kTransientLimitsMagic || values[1] != kTransientLimitsVersion) {
+    big2::Warning(spdlog::fmt_lib::format("The transient limits file {} is invalid and will be rewritten", transient_limits_file_.string()).c_str());
+    has_new_high_water_marks_ = true;
+    return;
+  }
+
+  transient_vertex_high_water_mark_ = values[2];
+  transient_index_high_water_mark_ = values[3];
+}
+
+void BgfxInitializationScoped::SaveTransientHighWaterMarks() const {
+  std::filesystem::path temporary_path = transient_limits_file_;
+  temporary_path += ".tmp";
+
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    const std::array<std::uint32_t, 4> values{kTransientLimitsMagic, kTransientLimitsVersion, transient_vertex_high_water_mark_, transient_index_high_water_mark_};
+    file.write(reinterpret_cast<const char *>(values.data()), sizeof(values));
+    if (!file) {
+      big2::Warning(spdlog::fmt_lib::format("Couldn't write the transient limits file {}", temporary_path.string()).c_str());
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, transient_limits_file_, error);
+  if (!big2::SoftValidate(!error, spdlog::fmt_lib::format("Couldn't replace the transient limits file {}", transient_limits_file_.string()).c_str())) {
+    std::filesystem::remove(temporary_path, error);
+  }
+}
 }
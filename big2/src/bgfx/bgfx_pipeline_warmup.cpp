@@ -0,0 +1,285 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_pipeline_warmup.h>
+#include <big2/bgfx/bgfx_utils.h>
+#include <big2/asserts.h>
+#include <big2/hash.h>
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <optional>
+#include <string_view>
+
+namespace big2 {
+
+static constexpr std::uint32_t kWarmupMagic = 0x57503242; // "B2PW"
+static constexpr std::uint32_t kWarmupVersion = 1;
+static constexpr std::uint32_t kReplayVertexCount = 3;
+
+BgfxPipelineWarmup *BgfxPipelineWarmup::instance_ = nullptr;
+
+struct BgfxPipelineWarmup::Replay {
+  Replay() = default;
+  Replay(Replay &&) = delete;
+  Replay &operator=(Replay &&) = delete;
+  Replay(const Replay &) = delete;
+  Replay &operator=(const Replay &) = delete;
+  ~Replay() { ReleaseView(); }
+
+  void Schedule(const std::weak_ptr<Replay> &self);
+  void ReplayFrame(const std::weak_ptr<Replay> &self);
+  void ReplayNext();
+  void PrepareView();
+  void ReleaseView();
+
+  std::deque<PipelineDescription> pending;
+  std::vector<ProgramReference> programs;
+  FrameScheduler *scheduler = nullptr;
+  FrameScheduler::Priority priority = FrameScheduler::Priority::High;
+  std::uint32_t replays_per_frame = 1;
+  bool is_scheduled = false;
+  PooledRenderTarget target;
+  std::optional<bgfx::ViewId> view_id;
+};
+
+void BgfxPipelineWarmup::Replay::PrepareView() {
+  if (view_id.has_value()) {
+    return;
+  }
+
+  RenderTargetDescriptor descriptor;
+  descriptor.size = {1, 1};
+  descriptor.depth_format = bgfx::TextureFormat::D24S8;
+  target = GetRenderTargetPool().Acquire(descriptor);
+
+  view_id = ReserveViewId();
+  bgfx::setViewName(*view_id, "Pipeline warmup");
+  bgfx::setViewFrameBuffer(*view_id, target.frame_buffer);
+  bgfx::setViewRect(*view_id, 0, 0, 1, 1);
+  bgfx::setViewClear(*view_id, BGFX_CLEAR_NONE);
+}
+
+void BgfxPipelineWarmup::Replay::ReleaseView() {
+  if (view_id.has_value()) {
+    bgfx::resetView(*view_id);
+    FreeViewId(*view_id);
+    view_id.reset();
+  }
+
+  if (target.IsValid()) {
+    GetRenderTargetPool().Release(target);
+    target = {};
+  }
+}
+
+void BgfxPipelineWarmup::Replay::Schedule(const std::weak_ptr<Replay> &self) {
+  if (is_scheduled || pending.empty()) {
+    return;
+  }
+
+  is_scheduled = true;
+  scheduler->Enqueue("big2::PipelineWarmup", [self]() {
+    if (std::shared_ptr<Replay> replay = self.lock(); replay != nullptr) {
+      replay->is_scheduled = false;
+      replay->ReplayFrame(self);
+    }
+  }, priority);
+}
+
+void BgfxPipelineWarmup::Replay::ReplayFrame(const std::weak_ptr<Replay> &self) {
+  for (std::uint32_t i = 0; i < replays_per_frame && !pending.empty(); ++i) {
+    ReplayNext();
+  }
+
+  if (!pending.empty()) {
+    Schedule(self);
+    return;
+  }
+
+  // Released on the next frame, after the view was submitted
+  scheduler->Enqueue("big2::PipelineWarmup::Release", [self]() {
+    if (std::shared_ptr<Replay> replay = self.lock(); replay != nullptr && replay->pending.empty()) {
+      replay->ReleaseView();
+    }
+  }, FrameScheduler::Priority::Low);
+}
+
+void BgfxPipelineWarmup::Replay::ReplayNext() {
+  const PipelineDescription pipeline = pending.front();
+  pending.pop_front();
+
+  PrepareView();
+  ProgramReference &program = programs.emplace_back(GetProgram(HashedName(pipeline.vertex_shader), HashedName(pipeline.fragment_shader)));
+  const bgfx::ProgramHandle program_handle = program.Get();
+
+  const bool has_vertices = pipeline.layout.getStride() > 0;
+  if (has_vertices && bgfx::getAvailTransientVertexBuffer(kReplayVertexCount, pipeline.layout) < kReplayVertexCount) {
+    big2::Warning("Out of transient vertex buffer space, a pipeline is skipped by the warmup");
+  } else if (bgfx::isValid(program_handle)) {
+    if (has_vertices) {
+      // All vertices at the origin, the triangle covers no pixels but the pipeline has to be created for it
+      bgfx::TransientVertexBuffer vertex_buffer{};
+      bgfx::allocTransientVertexBuffer(&vertex_buffer, kReplayVertexCount, pipeline.layout);
+      std::memset(vertex_buffer.data, 0, vertex_buffer.size);
+      bgfx::setVertexBuffer(0, &vertex_buffer);
+    }
+
+    bgfx::setState(pipeline.state);
+    bgfx::submit(*view_id, program_handle);
+  }
+}
+
+BgfxPipelineWarmup::BgfxPipelineWarmup(std::filesystem::path file) : file_(std::move(file)) {
+  Expects(instance_ == nullptr);
+  instance_ = this;
+  Load();
+}
+
+BgfxPipelineWarmup::~BgfxPipelineWarmup() {
+  if (is_dirty_) {
+    Save();
+  }
+
+  replay_.reset();
+  instance_ = nullptr;
+}
+
+void BgfxPipelineWarmup::Record(const ProgramReference &program, std::uint64_t state, const bgfx::VertexLayout &layout) {
+  if (!program.IsValid()) {
+    return;
+  }
+
+  PipelineDescription pipeline;
+  pipeline.vertex_shader = program.GetVertexShader().hash;
+  pipeline.fragment_shader = program.GetFragmentShader().hash;
+  pipeline.state = state;
+  pipeline.layout = layout;
+
+  if (recorded_keys_.insert(GetPipelineKey(pipeline)).second) {
+    recorded_.push_back(pipeline);
+    is_dirty_ = true;
+  }
+}
+
+std::size_t BgfxPipelineWarmup::Enqueue(FrameScheduler &scheduler, FrameScheduler::Priority priority) {
+  if (replay_ == nullptr) {
+    replay_ = std::make_shared<Replay>();
+  }
+  replay_->scheduler = &scheduler;
+  replay_->priority = priority;
+  replay_->replays_per_frame = replays_per_frame_;
+
+  // Pipelines whose shaders are gone can't be replayed and aren't saved again
+  std::erase_if(recorded_, [this](const PipelineDescription &pipeline) {
+    if (IsShaderAvailable(HashedName(pipeline.vertex_shader)) && IsShaderAvailable(HashedName(pipeline.fragment_shader))) {
+      return false;
+    }
+    recorded_keys_.erase(GetPipelineKey(pipeline));
+    is_dirty_ = true;
+    return true;
+  });
+
+  replay_->pending.insert(replay_->pending.end(), recorded_.begin(), recorded_.end());
+  replay_->Schedule(replay_);
+  return recorded_.size();
+}
+
+void BgfxPipelineWarmup::SetReplaysPerFrame(std::uint32_t count) {
+  big2::Validate(count > 0, "At least one pipeline has to be replayed per frame");
+  replays_per_frame_ = count;
+  if (replay_ != nullptr) {
+    replay_->replays_per_frame = count;
+  }
+}
+
+std::size_t BgfxPipelineWarmup::GetPendingCount() const {
+  return replay_ != nullptr ? replay_->pending.size() : 0;
+}
+
+std::uint64_t BgfxPipelineWarmup::GetPipelineKey(const PipelineDescription &pipeline) {
+  const std::array<std::uint64_t, 4> values{pipeline.vertex_shader, pipeline.fragment_shader, pipeline.state, pipeline.layout.m_hash};
+  return HashName(std::string_view(reinterpret_cast<const char *>(values.data()), sizeof(values)));
+}
+
+void BgfxPipelineWarmup::Save() {
+  std::filesystem::path temporary_path = file_;
+  temporary_path += ".tmp";
+
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    const std::array<std::uint32_t, 4> header{kWarmupMagic, kWarmupVersion, bgfx::Attrib::Count, gsl::narrow_cast<std::uint32_t>(recorded_.size())};
+    file.write(reinterpret_cast<const char *>(header.data()), sizeof(header));
+
+    for (const PipelineDescription &pipeline : recorded_) {
+      file.write(reinterpret_cast<const char *>(&pipeline.vertex_shader), sizeof(pipeline.vertex_shader));
+      file.write(reinterpret_cast<const char *>(&pipeline.fragment_shader), sizeof(pipeline.fragment_shader));
+      file.write(reinterpret_cast<const char *>(&pipeline.state), sizeof(pipeline.state));
+      file.write(reinterpret_cast<const char *>(&pipeline.layout.m_hash), sizeof(pipeline.layout.m_hash));
+      file.write(reinterpret_cast<const char *>(&pipeline.layout.m_stride), sizeof(pipeline.layout.m_stride));
+      file.write(reinterpret_cast<const char *>(pipeline.layout.m_offset), sizeof(pipeline.layout.m_offset));
+      file.write(reinterpret_cast<const char *>(pipeline.layout.m_attributes), sizeof(pipeline.layout.m_attributes));
+    }
+
+    if (!file) {
+      big2::Warning(spdlog::fmt_lib::format("Couldn't write the pipeline warmup file {}", temporary_path.string()).c_str());
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, file_, error);
+  if (!big2::SoftValidate(!error, spdlog::fmt_lib::format("Couldn't replace the pipeline warmup file {}", file_.string()).c_str())) {
+    std::filesystem::remove(temporary_path, error);
+    return;
+  }
+
+  is_dirty_ = false;
+}
+
+void BgfxPipelineWarmup::Load() {
+  std::ifstream file(file_, std::ios::binary);
+  if (!file) {
+    return;
+  }
+
+  std::array<std::uint32_t, 4> header{};
+  file.read(reinterpret_cast<char *>(header.data()), sizeof(header));
+  if (!file || header[0] != kWarmupMagic || header[1] != kWarmupVersion || header[2] != bgfx::Attrib::Count) {
+    big2::Warning(spdlog::fmt_lib::format("The pipeline warmup file {} is invalid and will be rewritten", file_.string()).c_str());
+    is_dirty_ = true;
+    return;
+  }
+
+  for (std::uint32_t i = 0; i < header[3]; ++i) {
+    PipelineDescription pipeline;
+    file.read(reinterpret_cast<char *>(&pipeline.vertex_shader), sizeof(pipeline.vertex_shader));
+    file.read(reinterpret_cast<char *>(&pipeline.fragment_shader), sizeof(pipeline.fragment_shader));
+    file.read(reinterpret_cast<char *>(&pipeline.state), sizeof(pipeline.state));
+    file.read(reinterpret_cast<char *>(&pipeline.layout.m_hash), sizeof(pipeline.layout.m_hash));
+    file.read(reinterpret_cast<char *>(&pipeline.layout.m_stride), sizeof(pipeline.layout.m_stride));
+    file.read(reinterpret_cast<char *>(pipeline.layout.m_offset), sizeof(pipeline.layout.m_offset));
+    file.read(reinterpret_cast<char *>(pipeline.layout.m_attributes), sizeof(pipeline.layout.m_attributes));
+    if (!file) {
+      big2::Warning(spdlog::fmt_lib::format("The pipeline warmup file {} is cut short", file_.string()).c_str());
+      is_dirty_ = true;
+      break;
+    }
+
+    if (recorded_keys_.insert(GetPipelineKey(pipeline)).second) {
+      recorded_.push_back(pipeline);
+    }
+  }
+}
+
+void RecordPipeline(const ProgramReference &program, std::uint64_t state, const bgfx::VertexLayout &layout) {
+  if (BgfxPipelineWarmup *warmup = BgfxPipelineWarmup::GetInstance(); warmup != nullptr) {
+    warmup->Record(program, state, layout);
+  }
+}
+
+}
@@ -0,0 +1,382 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_program_registry.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/bgfx/bgfx_shader_cache.h>
+#include <big2/asserts.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <bit>
+#include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace big2 {
+
+namespace detail {
+struct ProgramEntry {
+  std::uint64_t vertex_shader = 0;
+  std::uint64_t fragment_shader = 0;
+  bgfx::ProgramHandle handle = BGFX_INVALID_HANDLE;
+  std::uint32_t reference_count = 0;
+};
+}
+
+struct ShaderPairHash {
+  std::size_t operator()(const std::pair<std::uint64_t, std::uint64_t> &pair) const {
+    return std::hash<std::uint64_t>{}(pair.first ^ (pair.second * 0x9e3779b97f4a7c15ull));
+  }
+};
+
+struct ShaderVariantKeys {
+  std::string shader;
+  std::filesystem::path source;
+  std::vector<std::string> keys;
+};
+
+struct ShaderVariant {
+  std::uint64_t shader = 0;
+  ShaderVariantMask mask = 0;
+};
+
+// Looking for a fallback goes through the sub-masks, this keeps it short for shaders with many keys
+static constexpr std::size_t kMaxFallbackCandidates = 4096;
+
+static std::unordered_map<std::uint64_t, const bgfx::EmbeddedShader *> embedded_shaders;
+static std::unordered_map<std::uint64_t, std::vector<std::uint8_t>> replaced_shader_binaries;
+static std::unordered_map<std::uint64_t, ShaderVariantKeys> shader_variant_keys;
+static std::unordered_map<std::uint64_t, ShaderVariant> shader_variants;
+static std::unordered_set<std::uint64_t> requested_shader_variants;
+static ShaderVariantCompiler shader_variant_compiler;
+// Node based, so the entries don't move while references point to them
+static std::unordered_map<std::pair<std::uint64_t, std::uint64_t>, detail::ProgramEntry, ShaderPairHash> programs;
+
+static std::uint64_t GetShaderVariantHash(std::uint64_t shader, ShaderVariantMask mask) {
+  return mask == 0 ? shader : HashName(spdlog::fmt_lib::format("_variant{}", mask), shader);
+}
+
+static const bgfx::EmbeddedShader::Data *FindEmbeddedShaderData(std::uint64_t name_hash, bgfx::RendererType::Enum renderer_type) {
+  auto it = embedded_shaders.find(name_hash);
+  if (it == embedded_shaders.end()) {
+    return nullptr;
+  }
+
+  for (const bgfx::EmbeddedShader::Data *data = it->second->data; data->type != bgfx::RendererType::Count; ++data) {
+    if (data->type == renderer_type && data->size > 1) {
+      return data;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief The cache id of a variant. It includes the binary of the shader the variant is made of, so rebuilding
+ * the app with a changed shader doesn't pick up variants of the old one.
+ */
+static std::uint64_t GetShaderVariantCacheId(std::uint64_t variant_hash, const ShaderVariant &variant, bgfx::RendererType::Enum renderer_type) {
+  std::uint64_t id = HashName(bgfx::getRendererName(renderer_type), variant_hash);
+  if (const bgfx::EmbeddedShader::Data *data = FindEmbeddedShaderData(variant.shader, renderer_type); data != nullptr) {
+    id = HashName(std::string_view(reinterpret_cast<const char *>(data->data), data->size), id);
+  }
+  return id;
+}
+
+static bool ReadCachedShaderVariant(std::uint64_t variant_hash, const ShaderVariant &variant, bgfx::RendererType::Enum renderer_type) {
+  BgfxShaderCache *cache = BgfxShaderCache::GetInstance();
+  if (cache == nullptr) {
+    return false;
+  }
+
+  const std::uint64_t id = GetShaderVariantCacheId(variant_hash, variant, renderer_type);
+  const std::uint32_t size = cache->GetEntrySize(id);
+  if (size == 0) {
+    return false;
+  }
+
+  std::vector<std::uint8_t> binary(size);
+  if (!cache->Read(id, binary.data(), size)) {
+    return false;
+  }
+
+  replaced_shader_binaries.insert_or_assign(variant_hash, std::move(binary));
+  return true;
+}
+
+static void RequestShaderVariant(std::uint64_t variant_hash, const ShaderVariant &variant) {
+  auto keys = shader_variant_keys.find(variant.shader);
+  if (!requested_shader_variants.insert(variant_hash).second || keys == shader_variant_keys.end()) {
+    return;
+  }
+
+  if (!shader_variant_compiler || keys->second.source.empty()) {
+    big2::Warning(spdlog::fmt_lib::format("Variant {} of {} wasn't precompiled and can't be compiled, using the closest precompiled one",
+                                          variant.mask,
+                                          keys->second.shader).c_str());
+    return;
+  }
+
+  ShaderVariantRequest request;
+  request.variant = HashedName(variant_hash);
+  request.name = spdlog::fmt_lib::format("{}_variant{}", keys->second.shader, variant.mask);
+  request.source = keys->second.source;
+  for (std::size_t bit = 0; bit < keys->second.keys.size(); ++bit) {
+    if ((variant.mask & (1u << bit)) != 0) {
+      request.defines.push_back(keys->second.keys[bit]);
+    }
+  }
+  shader_variant_compiler(std::move(request));
+}
+
+/**
+ * @brief Finds the variant with the most keys of the mask that has a binary, the shader itself if there is none.
+ */
+static std::uint64_t FindFallbackShaderVariant(const ShaderVariant &variant) {
+  std::uint64_t best_hash = variant.shader;
+  int best_key_count = 0;
+
+  std::size_t candidates = 0;
+  for (ShaderVariantMask mask = (variant.mask - 1) & variant.mask; mask != 0 && candidates < kMaxFallbackCandidates; mask = (mask - 1) & variant.mask) {
+    candidates++;
+    const int key_count = std::popcount(mask);
+    const std::uint64_t hash = GetShaderVariantHash(variant.shader, mask);
+    if (key_count > best_key_count && (embedded_shaders.contains(hash) || replaced_shader_binaries.contains(hash))) {
+      best_hash = hash;
+      best_key_count = key_count;
+    }
+  }
+
+  return best_hash;
+}
+
+static bgfx::ShaderHandle CreateEmbeddedShader(std::uint64_t name_hash, bgfx::RendererType::Enum renderer_type) {
+  auto variant = shader_variants.find(name_hash);
+  if (variant != shader_variants.end() && !embedded_shaders.contains(name_hash) && !replaced_shader_binaries.contains(name_hash)
+      && !ReadCachedShaderVariant(name_hash, variant->second, renderer_type)) {
+    RequestShaderVariant(name_hash, variant->second);
+    name_hash = FindFallbackShaderVariant(variant->second);
+  }
+
+  auto it = embedded_shaders.find(name_hash);
+
+  auto replaced_binary = replaced_shader_binaries.find(name_hash);
+  if (replaced_binary != replaced_shader_binaries.end()) {
+    const std::vector<std::uint8_t> &binary = replaced_binary->second;
+    bgfx::ShaderHandle handle = bgfx::createShader(bgfx::copy(binary.data(), gsl::narrow_cast<std::uint32_t>(binary.size())));
+    if (it != embedded_shaders.end()) {
+      bgfx::setName(handle, it->second->name);
+    }
+    return handle;
+  }
+
+  big2::Validate(it != embedded_shaders.end(), spdlog::fmt_lib::format("No embedded shader was registered with the hash {:016x}", name_hash).c_str());
+
+  if (const bgfx::EmbeddedShader::Data *data = FindEmbeddedShaderData(name_hash, renderer_type); data != nullptr) {
+    bgfx::ShaderHandle handle = bgfx::createShader(bgfx::makeRef(data->data, data->size));
+    bgfx::setName(handle, it->second->name);
+    return handle;
+  }
+
+  big2::Error(spdlog::fmt_lib::format("Embedded shader {} has no binary for the current renderer", it->second->name).c_str());
+  return BGFX_INVALID_HANDLE;
+}
+
+static void AddReference(detail::ProgramEntry *entry) {
+  if (entry != nullptr) {
+    entry->reference_count++;
+  }
+}
+
+static void RemoveReference(detail::ProgramEntry *entry) {
+  if (entry == nullptr || --entry->reference_count > 0) {
+    return;
+  }
+
+  if (bgfx::isValid(entry->handle)) {
+    DestroyDeferred(entry->handle);
+  }
+  programs.erase({entry->vertex_shader, entry->fragment_shader});
+}
+
+ProgramReference::ProgramReference(detail::ProgramEntry *entry) : entry_(entry) {
+  AddReference(entry_);
+}
+
+ProgramReference::ProgramReference(ProgramReference &&other) noexcept : entry_(std::exchange(other.entry_, nullptr)) {
+}
+
+ProgramReference &ProgramReference::operator=(ProgramReference &&other) noexcept {
+  if (this != &other) {
+    RemoveReference(entry_);
+    entry_ = std::exchange(other.entry_, nullptr);
+  }
+  return *this;
+}
+
+ProgramReference::ProgramReference(const ProgramReference &other) : entry_(other.entry_) {
+  AddReference(entry_);
+}
+
+ProgramReference &ProgramReference::operator=(const ProgramReference &other) {
+  if (this != &other) {
+    AddReference(other.entry_);
+    RemoveReference(entry_);
+    entry_ = other.entry_;
+  }
+  return *this;
+}
+
+ProgramReference::~ProgramReference() {
+  RemoveReference(entry_);
+}
+
+static bgfx::ProgramHandle CreateProgram(const detail::ProgramEntry &entry) {
+  constexpr bool kDestroyShaders = true;
+  const bgfx::RendererType::Enum renderer_type = bgfx::getRendererType();
+  return TrackResource(bgfx::createProgram(CreateEmbeddedShader(entry.vertex_shader, renderer_type),
+                                           CreateEmbeddedShader(entry.fragment_shader, renderer_type),
+                                           kDestroyShaders));
+}
+
+bgfx::ProgramHandle ProgramReference::Get() const {
+  if (entry_ == nullptr) {
+    return BGFX_INVALID_HANDLE;
+  }
+
+  if (!bgfx::isValid(entry_->handle)) {
+    entry_->handle = CreateProgram(*entry_);
+  }
+
+  return entry_->handle;
+}
+
+HashedName ProgramReference::GetVertexShader() const {
+  return HashedName(entry_ != nullptr ? entry_->vertex_shader : 0);
+}
+
+HashedName ProgramReference::GetFragmentShader() const {
+  return HashedName(entry_ != nullptr ? entry_->fragment_shader : 0);
+}
+
+void ProgramReference::Reset() {
+  RemoveReference(std::exchange(entry_, nullptr));
+}
+
+void RegisterEmbeddedShaders(const bgfx::EmbeddedShader *shaders) {
+  for (const bgfx::EmbeddedShader *shader = shaders; shader->name != nullptr; ++shader) {
+    auto [it, is_inserted] = embedded_shaders.try_emplace(HashName(shader->name), shader);
+    if (!is_inserted && it->second != shader && std::string_view(it->second->name) != shader->name) {
+      big2::Error(spdlog::fmt_lib::format("Embedded shaders {} and {} have the same hash", it->second->name, shader->name).c_str());
+    }
+  }
+}
+
+ProgramReference GetProgram(HashedName vertex_shader, HashedName fragment_shader) {
+  auto [it, is_inserted] = programs.try_emplace({vertex_shader.hash, fragment_shader.hash});
+  if (is_inserted) {
+    it->second.vertex_shader = vertex_shader.hash;
+    it->second.fragment_shader = fragment_shader.hash;
+  }
+  return ProgramReference(&it->second);
+}
+
+bool IsShaderAvailable(HashedName shader) {
+  return embedded_shaders.contains(shader.hash) || replaced_shader_binaries.contains(shader.hash) || shader_variants.contains(shader.hash);
+}
+
+std::size_t ReplaceShaderBinary(HashedName shader, std::vector<std::uint8_t> binary) {
+  // Variants of a shader that was replaced themselves aren't cached, they don't match the embedded shader anymore
+  auto variant = shader_variants.find(shader.hash);
+  BgfxShaderCache *cache = BgfxShaderCache::GetInstance();
+  if (cache != nullptr && variant != shader_variants.end() && !binary.empty() && !replaced_shader_binaries.contains(variant->second.shader)) {
+    const std::uint64_t id = GetShaderVariantCacheId(shader.hash, variant->second, bgfx::getRendererType());
+    cache->Write(id, binary.data(), gsl::narrow_cast<std::uint32_t>(binary.size()));
+  }
+
+  replaced_shader_binaries.insert_or_assign(shader.hash, std::move(binary));
+
+  std::size_t recreated_count = 0;
+  for (auto &[shaders, entry] : programs) {
+    if (!bgfx::isValid(entry.handle) || (entry.vertex_shader != shader.hash && entry.fragment_shader != shader.hash)) {
+      continue;
+    }
+
+    const bgfx::ProgramHandle handle = CreateProgram(entry);
+    if (!bgfx::isValid(handle)) {
+      big2::Error(spdlog::fmt_lib::format("Program with shader {:016x} couldn't be recreated, keeping the old one", shader.hash).c_str());
+      continue;
+    }
+
+    DestroyDeferred(entry.handle);
+    entry.handle = handle;
+    recreated_count++;
+  }
+
+  return recreated_count;
+}
+
+void RegisterShaderVariants(const ShaderVariantDeclaration *declarations) {
+  for (const ShaderVariantDeclaration *declaration = declarations; declaration->shader != nullptr; ++declaration) {
+    ShaderVariantKeys &keys = shader_variant_keys[HashName(declaration->shader)];
+    keys.shader = declaration->shader;
+    keys.source = declaration->source_path != nullptr ? declaration->source_path : "";
+    keys.keys.clear();
+
+    std::istringstream key_stream(declaration->keys != nullptr ? declaration->keys : "");
+    for (std::string key; key_stream >> key;) {
+      keys.keys.push_back(std::move(key));
+    }
+
+    big2::Validate(keys.keys.size() <= sizeof(ShaderVariantMask) * 8,
+                   spdlog::fmt_lib::format("Shader {} has more variant keys than fit in a mask", keys.shader).c_str());
+  }
+}
+
+ShaderVariantMask GetShaderVariantMask(HashedName shader, std::initializer_list<std::string_view> keys) {
+  auto it = shader_variant_keys.find(shader.hash);
+  if (!big2::SoftValidate(it != shader_variant_keys.end(), spdlog::fmt_lib::format("Shader {:016x} has no registered variants", shader.hash).c_str())) {
+    return 0;
+  }
+
+  ShaderVariantMask mask = 0;
+  for (std::string_view key : keys) {
+    auto bit = std::ranges::find(it->second.keys, key);
+    if (big2::SoftValidate(bit != it->second.keys.end(), spdlog::fmt_lib::format("Shader {} has no variant key {}", it->second.shader, key).c_str())) {
+      mask |= 1u << std::distance(it->second.keys.begin(), bit);
+    }
+  }
+  return mask;
+}
+
+HashedName GetShaderVariant(HashedName shader, ShaderVariantMask mask) {
+  const std::uint64_t variant_hash = GetShaderVariantHash(shader.hash, mask);
+  if (mask != 0) {
+    shader_variants.try_emplace(variant_hash, ShaderVariant{.shader = shader.hash, .mask = mask});
+  }
+  return HashedName(variant_hash);
+}
+
+void SetShaderVariantCompiler(ShaderVariantCompiler compiler) {
+  shader_variant_compiler = std::move(compiler);
+  // Variants that were given up on may be compiled now
+  requested_shader_variants.clear();
+}
+
+void ReleasePrograms() {
+  for (auto &[shaders, entry] : programs) {
+    if (bgfx::isValid(entry.handle)) {
+      DestroyDeferred(entry.handle);
+      entry.handle = BGFX_INVALID_HANDLE;
+    }
+  }
+}
+
+std::size_t GetReferencedProgramCount() {
+  return programs.size();
+}
+
+}
@@ -0,0 +1,15 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_render_state.h>
+#include <big2/asserts.h>
+#include <spdlog/spdlog.h>
+
+namespace big2::detail {
+
+void ReportInvalidRenderState(std::string_view reason) {
+  big2::Validate(false, spdlog::fmt_lib::format("Invalid render state: {}", reason).c_str());
+}
+
+}
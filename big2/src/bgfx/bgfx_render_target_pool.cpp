@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_render_target_pool.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/asserts.h>
+#include <array>
+#include <functional>
+
+namespace big2 {
+
+static void HashCombine(std::size_t &seed, std::size_t value) {
+  seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+}
+
+std::size_t RenderTargetDescriptorHash::operator()(const RenderTargetDescriptor &descriptor) const {
+  std::size_t seed = 0;
+  HashCombine(seed, std::hash<std::uint32_t>{}((static_cast<std::uint32_t>(descriptor.size.x) << 16) | descriptor.size.y));
+  HashCombine(seed, std::hash<std::uint32_t>{}((static_cast<std::uint32_t>(descriptor.color_format) << 16) | descriptor.depth_format));
+  HashCombine(seed, std::hash<std::uint64_t>{}(descriptor.flags));
+  return seed;
+}
+
+PooledRenderTarget BgfxRenderTargetPool::Acquire(const RenderTargetDescriptor &descriptor) {
+  auto it = free_targets_by_descriptor_.find(descriptor);
+  if (it != free_targets_by_descriptor_.end()) {
+    PooledRenderTarget target = *it->second;
+    free_targets_.erase(it->second);
+    free_targets_by_descriptor_.erase(it);
+    free_bytes_ -= target.byte_estimate;
+    used_bytes_ += target.byte_estimate;
+    return target;
+  }
+
+  PooledRenderTarget target = Create(descriptor);
+  used_bytes_ += target.byte_estimate;
+  EvictOverCap();
+  return target;
+}
+
+void BgfxRenderTargetPool::Release(const PooledRenderTarget &target) {
+  if (!target.IsValid()) {
+    return;
+  }
+
+  used_bytes_ -= target.byte_estimate;
+  free_bytes_ += target.byte_estimate;
+  free_targets_.push_front(target);
+  free_targets_by_descriptor_.emplace(target.descriptor, free_targets_.begin());
+  EvictOverCap();
+}
+
+void BgfxRenderTargetPool::SetMemoryCap(std::uint64_t bytes) {
+  memory_cap_ = bytes;
+  EvictOverCap();
+}
+
+void BgfxRenderTargetPool::Clear() {
+  while (!free_targets_.empty()) {
+    EvictLeastRecentlyUsed();
+  }
+}
+
+PooledRenderTarget BgfxRenderTargetPool::Create(const RenderTargetDescriptor &descriptor) {
+  big2::Validate(descriptor.size.x > 0 && descriptor.size.y > 0, "Render targets can't be empty");
+
+  constexpr bool kHasMips = false;
+  constexpr std::uint16_t kLayersCount = 1;
+  constexpr bool kDestroyTextures = true;
+
+  PooledRenderTarget target;
+  target.descriptor = descriptor;
+  target.color = bgfx::createTexture2D(descriptor.size.x, descriptor.size.y, kHasMips, kLayersCount, descriptor.color_format, descriptor.flags | BGFX_TEXTURE_RT);
+  target.byte_estimate = EstimateTextureBytes(descriptor.size, kHasMips, kLayersCount, descriptor.color_format);
+
+  std::array<bgfx::TextureHandle, 2> textures = {target.color, BGFX_INVALID_HANDLE};
+  std::uint8_t textures_count = 1;
+  if (descriptor.depth_format != bgfx::TextureFormat::Count) {
+    target.depth = bgfx::createTexture2D(descriptor.size.x, descriptor.size.y, kHasMips, kLayersCount, descriptor.depth_format, BGFX_TEXTURE_RT_WRITE_ONLY);
+    target.byte_estimate += EstimateTextureBytes(descriptor.size, kHasMips, kLayersCount, descriptor.depth_format);
+    textures[textures_count++] = target.depth;
+  }
+
+  // The textures are owned by the frame buffer so only the frame buffer is tracked with the memory of both
+  target.frame_buffer = TrackResource(bgfx::createFrameBuffer(textures_count, textures.data(), kDestroyTextures), target.byte_estimate);
+  return target;
+}
+
+void BgfxRenderTargetPool::Destroy(const PooledRenderTarget &target) {
+  DestroyDeferred(target.frame_buffer);
+}
+
+void BgfxRenderTargetPool::EvictOverCap() {
+  while (!free_targets_.empty() && used_bytes_ + free_bytes_ > memory_cap_) {
+    EvictLeastRecentlyUsed();
+  }
+}
+
+void BgfxRenderTargetPool::EvictLeastRecentlyUsed() {
+  const FreeList::iterator target = std::prev(free_targets_.end());
+
+  auto [begin, end] = free_targets_by_descriptor_.equal_range(target->descriptor);
+  for (auto it = begin; it != end; ++it) {
+    if (it->second == target) {
+      free_targets_by_descriptor_.erase(it);
+      break;
+    }
+  }
+
+  free_bytes_ -= target->byte_estimate;
+  Destroy(*target);
+  free_targets_.erase(target);
+}
+
+}
@@ -0,0 +1,177 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace big2 {
+
+static_assert(static_cast<std::size_t>(BgfxHandleType::Count) == static_cast<std::size_t>(BgfxResourceCategory::View),
+              "Resource categories have to mirror the handle types");
+
+static constexpr std::array<gsl::czstring, static_cast<std::size_t>(BgfxResourceCategory::Count)> kCategoryNames = {
+    "DynamicIndexBuffer",
+    "DynamicVertexBuffer",
+    "FrameBuffer",
+    "IndexBuffer",
+    "IndirectBuffer",
+    "OcclusionQuery",
+    "Program",
+    "Shader",
+    "Texture",
+    "Uniform",
+    "VertexBuffer",
+    "VertexLayout",
+    "View",
+};
+
+static std::uint32_t MakeResourceKey(BgfxResourceCategory category, std::uint16_t index) {
+  return (static_cast<std::uint32_t>(category) << 16) | index;
+}
+
+static std::mutex tracker_mutex;
+static std::unordered_map<std::uint32_t, TrackedResource> tracked_resources;
+static std::array<BgfxResourceTotals, static_cast<std::size_t>(BgfxResourceCategory::Count)> category_totals;
+static std::uint64_t next_serial = 0;
+
+gsl::czstring GetResourceCategoryName(BgfxResourceCategory category) {
+  return category < BgfxResourceCategory::Count ? kCategoryNames.at(static_cast<std::size_t>(category)) : "Unknown";
+}
+
+std::int64_t BgfxResourceSnapshotDiff::GetByteGrowth() const {
+  std::int64_t growth = 0;
+  for (const TrackedResource &resource : created) {
+    growth += static_cast<std::int64_t>(resource.byte_estimate);
+  }
+  for (const TrackedResource &resource : destroyed) {
+    growth -= static_cast<std::int64_t>(resource.byte_estimate);
+  }
+  return growth;
+}
+
+void TrackView(bgfx::ViewId view_id, const std::source_location location) {
+  detail::TrackResource(BgfxResourceCategory::View, view_id, 0, location);
+}
+
+void UntrackView(bgfx::ViewId view_id) {
+  detail::UntrackResource(BgfxResourceCategory::View, view_id);
+}
+
+std::uint64_t EstimateTextureBytes(glm::u16vec2 size, bool has_mips, std::uint16_t layers_count, bgfx::TextureFormat::Enum format) {
+  bgfx::TextureInfo info{};
+  bgfx::calcTextureSize(info, size.x, size.y, 1, false, has_mips, layers_count, format);
+  return info.storageSize;
+}
+
+std::uint64_t EstimateWindowFrameBufferBytes(glm::u16vec2 size) {
+  constexpr std::uint64_t kColorBuffersCount = 2;
+  constexpr std::uint64_t kColorBytesPerPixel = 4;
+  constexpr std::uint64_t kDepthBytesPerPixel = 4;
+  const std::uint64_t pixels_count = static_cast<std::uint64_t>(size.x) * size.y;
+  return pixels_count * (kColorBuffersCount * kColorBytesPerPixel + kDepthBytesPerPixel);
+}
+
+BgfxResourceTotals GetResourceTotals(BgfxResourceCategory category) {
+  std::scoped_lock lock(tracker_mutex);
+  return category_totals.at(static_cast<std::size_t>(category));
+}
+
+BgfxResourceTotals GetResourceTotals() {
+  std::scoped_lock lock(tracker_mutex);
+  BgfxResourceTotals result;
+  for (const BgfxResourceTotals &totals : category_totals) {
+    result.count += totals.count;
+    result.bytes += totals.bytes;
+  }
+  return result;
+}
+
+BgfxResourceSnapshot TakeResourceSnapshot() {
+  BgfxResourceSnapshot snapshot;
+  {
+    std::scoped_lock lock(tracker_mutex);
+    snapshot.resources.reserve(tracked_resources.size());
+    for (const auto &[key, resource] : tracked_resources) {
+      snapshot.resources.push_back(resource);
+    }
+  }
+
+  std::ranges::sort(snapshot.resources, {}, &TrackedResource::serial);
+  return snapshot;
+}
+
+BgfxResourceSnapshotDiff DiffResourceSnapshots(const BgfxResourceSnapshot &before, const BgfxResourceSnapshot &after) {
+  BgfxResourceSnapshotDiff diff;
+  std::ranges::set_difference(after.resources, before.resources, std::back_inserter(diff.created), {}, &TrackedResource::serial, &TrackedResource::serial);
+  std::ranges::set_difference(before.resources, after.resources, std::back_inserter(diff.destroyed), {}, &TrackedResource::serial, &TrackedResource::serial);
+  return diff;
+}
+
+std::size_t ReportResourceLeaks() {
+  const BgfxResourceSnapshot snapshot = TakeResourceSnapshot();
+  for (const TrackedResource &resource : snapshot.resources) {
+    big2::Warning(spdlog::fmt_lib::format("Leaked {} {} ({} bytes) created on frame {}",
+                                          GetResourceCategoryName(resource.category),
+                                          resource.index,
+                                          resource.byte_estimate,
+                                          resource.creation_frame).c_str(),
+                  resource.location);
+  }
+
+  return snapshot.resources.size();
+}
+
+void ClearTrackedResources() {
+  std::scoped_lock lock(tracker_mutex);
+  tracked_resources.clear();
+  category_totals = {};
+}
+
+namespace detail {
+
+void TrackResource(BgfxResourceCategory category, std::uint16_t index, std::uint64_t byte_estimate, const std::source_location &location) {
+  const std::uint32_t creation_frame = GetSubmittedFrameCount();
+
+  std::scoped_lock lock(tracker_mutex);
+  TrackedResource resource{
+      .category = category,
+      .index = index,
+      .serial = next_serial++,
+      .byte_estimate = byte_estimate,
+      .creation_frame = creation_frame,
+      .location = location,
+  };
+
+  BgfxResourceTotals &totals = category_totals.at(static_cast<std::size_t>(category));
+  auto [it, is_inserted] = tracked_resources.try_emplace(MakeResourceKey(category, index), resource);
+  if (!is_inserted) {
+    // The previous resource with this index was destroyed without going through BIG2
+    totals.count--;
+    totals.bytes -= it->second.byte_estimate;
+    it->second = resource;
+  }
+  totals.count++;
+  totals.bytes += byte_estimate;
+}
+
+void UntrackResource(BgfxResourceCategory category, std::uint16_t index) {
+  std::scoped_lock lock(tracker_mutex);
+  auto it = tracked_resources.find(MakeResourceKey(category, index));
+  if (it == tracked_resources.end()) {
+    return;
+  }
+
+  BgfxResourceTotals &totals = category_totals.at(static_cast<std::size_t>(category));
+  totals.count--;
+  totals.bytes -= it->second.byte_estimate;
+  tracked_resources.erase(it);
+}
+
+}
+
+}
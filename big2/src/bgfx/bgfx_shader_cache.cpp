@@ -0,0 +1,298 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_shader_cache.h>
+#include <big2/asserts.h>
+#include <bx/bx.h>
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if BX_PLATFORM_LINUX || BX_PLATFORM_OSX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace big2 {
+
+static constexpr std::uint32_t kIndexMagic = 0x43533242; // "B2SC"
+static constexpr std::uint32_t kIndexVersion = 1;
+static constexpr gsl::czstring kIndexFileName = "index.bin";
+
+struct IndexHeader {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint64_t count;
+};
+
+struct IndexRecord {
+  std::uint64_t id;
+  std::uint32_t size;
+  std::uint32_t checksum;
+  std::uint64_t last_use;
+};
+
+BgfxShaderCache *BgfxShaderCache::instance_ = nullptr;
+
+static std::uint32_t CalculateChecksum(const void *data, std::uint32_t size) {
+  // FNV-1a
+  std::uint32_t hash = 2166136261u;
+  const auto *bytes = static_cast<const std::uint8_t *>(data);
+  for (std::uint32_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static bool WriteFileAtomically(const std::filesystem::path &path, const void *data, std::size_t size) {
+  std::filesystem::path temporary_path = path;
+  temporary_path += ".tmp";
+
+  {
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    file.write(static_cast<const char *>(data), gsl::narrow_cast<std::streamsize>(size));
+    if (!file) {
+      big2::Warning(spdlog::fmt_lib::format("Couldn't write shader cache file {}", temporary_path.string()).c_str());
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary_path, path, error);
+  if (error) {
+    big2::Warning(spdlog::fmt_lib::format("Couldn't replace shader cache file {}: {}", path.string(), error.message()).c_str());
+    std::filesystem::remove(temporary_path, error);
+    return false;
+  }
+
+  return true;
+}
+
+static std::vector<IndexRecord> ParseIndex(const std::uint8_t *data, std::size_t size) {
+  IndexHeader header{};
+  if (size < sizeof(header)) {
+    return {};
+  }
+
+  std::memcpy(&header, data, sizeof(header));
+  if (header.magic != kIndexMagic || header.version != kIndexVersion || header.count > (size - sizeof(header)) / sizeof(IndexRecord)) {
+    big2::Warning("The shader cache index is invalid and will be rebuilt");
+    return {};
+  }
+
+  std::vector<IndexRecord> records(header.count);
+  std::memcpy(records.data(), data + sizeof(header), records.size() * sizeof(IndexRecord));
+  return records;
+}
+
+static std::vector<IndexRecord> ReadIndex(const std::filesystem::path &path) {
+#if BX_PLATFORM_LINUX || BX_PLATFORM_OSX
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file < 0) {
+    return {};
+  }
+
+  std::vector<IndexRecord> records;
+  struct stat file_stat{};
+  if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0) {
+    const auto size = static_cast<std::size_t>(file_stat.st_size);
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (mapping != MAP_FAILED) {
+      records = ParseIndex(static_cast<const std::uint8_t *>(mapping), size);
+      munmap(mapping, size);
+    }
+  }
+
+  close(file);
+  return records;
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return {};
+  }
+
+  std::vector<std::uint8_t> data(static_cast<std::size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(data.data()), gsl::narrow_cast<std::streamsize>(data.size()));
+  return file ? ParseIndex(data.data(), data.size()) : std::vector<IndexRecord>{};
+#endif
+}
+
+BgfxShaderCache::BgfxShaderCache(std::filesystem::path directory, std::uint64_t max_bytes)
+  : directory_(std::move(directory))
+  , max_bytes_(max_bytes) {
+  Expects(instance_ == nullptr);
+  instance_ = this;
+
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    big2::Warning(spdlog::fmt_lib::format("Couldn't create the shader cache directory {}: {}", directory_.string(), error.message()).c_str());
+  }
+
+  std::scoped_lock lock(mutex_);
+  LoadIndex();
+}
+
+BgfxShaderCache::~BgfxShaderCache() {
+  {
+    std::scoped_lock lock(mutex_);
+    if (is_index_dirty_) {
+      SaveIndex();
+    }
+  }
+
+  instance_ = nullptr;
+}
+
+std::uint32_t BgfxShaderCache::GetEntrySize(std::uint64_t id) {
+  std::scoped_lock lock(mutex_);
+  auto it = entries_.find(id);
+  if (it == entries_.end()) {
+    statistics_.misses++;
+    return 0;
+  }
+
+  return it->second.size;
+}
+
+bool BgfxShaderCache::Read(std::uint64_t id, void *data, std::uint32_t size) {
+  std::scoped_lock lock(mutex_);
+  auto it = entries_.find(id);
+  if (it == entries_.end() || it->second.size != size) {
+    statistics_.misses++;
+    return false;
+  }
+
+  std::ifstream file(GetEntryPath(id), std::ios::binary);
+  file.read(static_cast<char *>(data), size);
+  if (!file || file.gcount() != size || CalculateChecksum(data, size) != it->second.checksum) {
+    big2::Warning(spdlog::fmt_lib::format("Shader cache entry {:016x} is damaged and will be dropped", id).c_str());
+    RemoveEntry(id);
+    is_index_dirty_ = true;
+    statistics_.misses++;
+    return false;
+  }
+
+  it->second.last_use = next_use_++;
+  is_index_dirty_ = true;
+  statistics_.hits++;
+  return true;
+}
+
+void BgfxShaderCache::Write(std::uint64_t id, const void *data, std::uint32_t size) {
+  std::scoped_lock lock(mutex_);
+  if (size > max_bytes_ || !WriteFileAtomically(GetEntryPath(id), data, size)) {
+    return;
+  }
+
+  Entry &entry = entries_[id];
+  total_bytes_ -= entry.size;
+  entry.size = size;
+  entry.checksum = CalculateChecksum(data, size);
+  entry.last_use = next_use_++;
+  total_bytes_ += size;
+  statistics_.writes++;
+
+  EvictOverLimit();
+  SaveIndex();
+}
+
+void BgfxShaderCache::Clear() {
+  std::scoped_lock lock(mutex_);
+  while (!entries_.empty()) {
+    RemoveEntry(entries_.begin()->first);
+  }
+  SaveIndex();
+}
+
+void BgfxShaderCache::SetMaxBytes(std::uint64_t bytes) {
+  std::scoped_lock lock(mutex_);
+  max_bytes_ = bytes;
+  EvictOverLimit();
+  if (is_index_dirty_) {
+    SaveIndex();
+  }
+}
+
+std::uint64_t BgfxShaderCache::GetTotalBytes() const {
+  std::scoped_lock lock(mutex_);
+  return total_bytes_;
+}
+
+std::size_t BgfxShaderCache::GetEntryCount() const {
+  std::scoped_lock lock(mutex_);
+  return entries_.size();
+}
+
+BgfxShaderCacheStatistics BgfxShaderCache::GetStatistics() const {
+  std::scoped_lock lock(mutex_);
+  return statistics_;
+}
+
+std::filesystem::path BgfxShaderCache::GetEntryPath(std::uint64_t id) const {
+  return directory_ / spdlog::fmt_lib::format("{:016x}.bin", id);
+}
+
+void BgfxShaderCache::LoadIndex() {
+  for (const IndexRecord &record : ReadIndex(directory_ / kIndexFileName)) {
+    std::error_code error;
+    if (std::filesystem::file_size(GetEntryPath(record.id), error) != record.size || error) {
+      // The entry file was deleted or replaced behind our back
+      is_index_dirty_ = true;
+      continue;
+    }
+
+    entries_[record.id] = Entry{.size = record.size, .checksum = record.checksum, .last_use = record.last_use};
+    total_bytes_ += record.size;
+    next_use_ = std::max(next_use_, record.last_use + 1);
+  }
+
+  EvictOverLimit();
+}
+
+void BgfxShaderCache::SaveIndex() {
+  std::vector<std::uint8_t> data(sizeof(IndexHeader) + entries_.size() * sizeof(IndexRecord));
+  const IndexHeader header{.magic = kIndexMagic, .version = kIndexVersion, .count = entries_.size()};
+  std::memcpy(data.data(), &header, sizeof(header));
+
+  std::size_t offset = sizeof(header);
+  for (const auto &[id, entry] : entries_) {
+    const IndexRecord record{.id = id, .size = entry.size, .checksum = entry.checksum, .last_use = entry.last_use};
+    std::memcpy(data.data() + offset, &record, sizeof(record));
+    offset += sizeof(record);
+  }
+
+  is_index_dirty_ = !WriteFileAtomically(directory_ / kIndexFileName, data.data(), data.size());
+}
+
+void BgfxShaderCache::EvictOverLimit() {
+  while (total_bytes_ > max_bytes_ && !entries_.empty()) {
+    const auto least_recently_used = std::ranges::min_element(entries_, {}, [](const auto &id_entry) { return id_entry.second.last_use; });
+    RemoveEntry(least_recently_used->first);
+    statistics_.evictions++;
+    is_index_dirty_ = true;
+  }
+}
+
+void BgfxShaderCache::RemoveEntry(std::uint64_t id) {
+  auto it = entries_.find(id);
+  if (it == entries_.end()) {
+    return;
+  }
+
+  total_bytes_ -= it->second.size;
+  entries_.erase(it);
+
+  std::error_code error;
+  std::filesystem::remove(GetEntryPath(id), error);
+}
+
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_uniform_registry.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/asserts.h>
+#include <big2/hash.h>
+#include <spdlog/spdlog.h>
+#include <unordered_map>
+
+namespace big2 {
+
+struct UniformEntry {
+  std::string name;
+  bgfx::UniformType::Enum type = bgfx::UniformType::Count;
+  std::uint16_t count = 0;
+  bgfx::UniformHandle handle = BGFX_INVALID_HANDLE;
+};
+
+static std::unordered_map<std::uint64_t, UniformEntry> uniforms;
+// Starts above the generation of uniform blocks that didn't get their handle yet
+static std::uint32_t uniforms_generation = 1;
+
+namespace detail {
+
+std::uint32_t GetUniformsGeneration() {
+  return uniforms_generation;
+}
+
+}
+
+bgfx::UniformHandle GetUniform(std::string_view name, bgfx::UniformType::Enum type, std::uint16_t count) {
+  const std::uint64_t hash = HashName(name);
+  if (auto it = uniforms.find(hash); it != uniforms.end()) {
+    big2::Validate(it->second.name == name, spdlog::fmt_lib::format("The uniform names {} and {} have the same hash", it->second.name, name).c_str());
+    big2::Validate(it->second.type == type && it->second.count == count,
+                   spdlog::fmt_lib::format("The uniform {} was already created with another type or count", name).c_str());
+    return it->second.handle;
+  }
+
+  const std::string name_string(name);
+  const bgfx::UniformHandle handle = TrackResource(bgfx::createUniform(name_string.c_str(), type, count));
+  if (!big2::SoftValidate(bgfx::isValid(handle), spdlog::fmt_lib::format("Couldn't create the uniform {}", name).c_str())) {
+    return handle;
+  }
+
+  UniformEntry &entry = uniforms[hash];
+  entry.name = name_string;
+  entry.type = type;
+  entry.count = count;
+  entry.handle = handle;
+  return handle;
+}
+
+void ReleaseUniforms() {
+  for (const auto &[hash, entry] : uniforms) {
+    DestroyDeferred(entry.handle);
+  }
+  uniforms.clear();
+  uniforms_generation++;
+}
+
+std::size_t GetUniformCount() {
+  return uniforms.size();
+}
+
+}
@@ -8,25 +8,45 @@
 #include <bx/bx.h>
 #include <native_window.h>
 #include <id_manager.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
 
 namespace big2 {
 
-static IdManager<bgfx::ViewId> view_id_manager;
+static AtomicIdManager<bgfx::ViewId> view_id_manager;
+static BgfxRenderTargetPool render_target_pool;
 
 void SetNativeWindowData(bgfx::Init &init_obj, gsl::not_null<GLFWwindow *> window) {
+  SetNativeDisplayData(init_obj.platformData);
+  init_obj.platformData.nwh = GetNativeWindowHandle(window);
+}
+
+void SetNativeDisplayData([[maybe_unused]] bgfx::PlatformData &platform_data) {
 #if BX_PLATFORM_LINUX
-  init_obj.platformData.ndt = glfwGetX11Display();
+  platform_data.ndt = glfwGetX11Display();
 #endif
-  init_obj.platformData.nwh = GetNativeWindowHandle(window);
 }
 
-bgfx::FrameBufferHandle CreateWindowFrameBuffer(gsl::not_null<GLFWwindow *> window) {
+bgfx::FrameBufferHandle CreateWindowFrameBuffer(gsl::not_null<GLFWwindow *> window, const std::source_location location) {
   glm::u16vec2 window_resolution = GetWindowResolution(window);
-  return bgfx::createFrameBuffer(GetNativeWindowHandle(window), window_resolution.x, window_resolution.y);
+  return TrackResource(bgfx::createFrameBuffer(GetNativeWindowHandle(window), window_resolution.x, window_resolution.y),
+                       EstimateWindowFrameBufferBytes(window_resolution),
+                       location);
+}
+
+bgfx::VertexBufferHandle CreateVertexBuffer(const bgfx::Memory *memory, const bgfx::VertexLayout &layout, std::uint16_t flags, const std::source_location location) {
+  const std::uint32_t size = memory->size;
+  return TrackResource(bgfx::createVertexBuffer(memory, layout, flags), size, location);
+}
+
+bgfx::IndexBufferHandle CreateIndexBuffer(const bgfx::Memory *memory, std::uint16_t flags, const std::source_location location) {
+  const std::uint32_t size = memory->size;
+  return TrackResource(bgfx::createIndexBuffer(memory, flags), size, location);
 }
 
-bgfx::ViewId ReserveViewId() {
-  return view_id_manager.Reserve();
+bgfx::ViewId ReserveViewId(const std::source_location location) {
+  const bgfx::ViewId view_id = view_id_manager.Reserve();
+  TrackView(view_id, location);
+  return view_id;
 }
 
 std::vector<bgfx::ViewId> GetReservedViewIds() {
@@ -34,19 +54,33 @@ std::vector<bgfx::ViewId> GetReservedViewIds() {
 }
 
 void FreeViewId(bgfx::ViewId value) {
+  UntrackView(value);
   view_id_manager.Free(value);
 }
 
+BgfxRenderTargetPool &GetRenderTargetPool() {
+  return render_target_pool;
+}
+
+PooledRenderTarget AcquireRenderTarget(const RenderTargetDescriptor &descriptor) {
+  return render_target_pool.Acquire(descriptor);
+}
+
+void ReleaseRenderTarget(const PooledRenderTarget &target) {
+  render_target_pool.Release(target);
+}
+
 bool BgfxSupportsMultipleWindows() {
   const bgfx::Caps* caps = bgfx::getCaps();
   return (caps->supported & BGFX_CAPS_SWAP_CHAIN) != 0;
 }
 
-void ResetWindowFrameBuffer(gsl::not_null<GLFWwindow *> window, bgfx::FrameBufferHandle &out_handle) {
+void ResetWindowFrameBuffer(gsl::not_null<GLFWwindow *> window, bgfx::FrameBufferHandle &out_handle, const std::source_location location) {
   if (bgfx::isValid(out_handle)) {
+    UntrackResource(out_handle);
     bgfx::destroy(out_handle);
   }
-  out_handle = CreateWindowFrameBuffer(window);
+  out_handle = CreateWindowFrameBuffer(window, location);
 }
 
 }
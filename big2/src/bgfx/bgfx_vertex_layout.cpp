@@ -0,0 +1,63 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/bgfx/bgfx_vertex_layout.h>
+#include <big2/asserts.h>
+#include <gsl/gsl>
+#include <spdlog/spdlog.h>
+#include <vector>
+
+namespace big2 {
+
+static std::vector<bgfx::VertexLayoutHandle> cached_vertex_layout_handles;
+// Starts above the generation of uncreated handles, so the first GetVertexLayoutHandle() creates one
+static std::uint32_t vertex_layout_handles_generation = 1;
+
+namespace detail {
+
+bgfx::VertexLayout CreateVertexLayout(std::span<const VertexAttribute> attributes, std::size_t stride) {
+  bgfx::VertexLayout layout;
+  layout.begin();
+
+  std::size_t offset = 0;
+  for (const VertexAttribute &attribute : attributes) {
+    if (attribute.offset > offset) {
+      layout.skip(gsl::narrow<std::uint8_t>(attribute.offset - offset));
+    }
+    layout.add(attribute.attribute, attribute.count, attribute.type, attribute.is_normalized, attribute.is_integer);
+    offset = attribute.offset + attribute.size;
+  }
+
+  if (stride > offset) {
+    layout.skip(gsl::narrow<std::uint8_t>(stride - offset));
+  }
+  layout.end();
+
+  big2::Validate(layout.getStride() == stride, spdlog::fmt_lib::format("The vertex layout has a stride of {} instead of {}", layout.getStride(), stride).c_str());
+  return layout;
+}
+
+bgfx::VertexLayoutHandle CreateCachedVertexLayoutHandle(const bgfx::VertexLayout &layout) {
+  const bgfx::VertexLayoutHandle handle = bgfx::createVertexLayout(layout);
+  cached_vertex_layout_handles.push_back(handle);
+  return handle;
+}
+
+std::uint32_t GetVertexLayoutHandlesGeneration() {
+  return vertex_layout_handles_generation;
+}
+
+}
+
+void ReleaseVertexLayoutHandles() {
+  for (const bgfx::VertexLayoutHandle handle : cached_vertex_layout_handles) {
+    if (bgfx::isValid(handle)) {
+      bgfx::destroy(handle);
+    }
+  }
+  cached_vertex_layout_handles.clear();
+  vertex_layout_handles_generation++;
+}
+
+}
@@ -188,6 +188,27 @@ void PollEvents() {
   SortEventsByWindow();
 }
 
+void WaitEvents() {
+  events.clear();
+  global_events.clear();
+  glfwWaitEvents();
+  SortEventsByWindow();
+}
+
+void WaitEvents(std::chrono::nanoseconds timeout) {
+  using double_duration_seconds = std::chrono::duration<double, std::chrono::seconds::period>;
+
+  if (timeout <= std::chrono::nanoseconds::zero()) {
+    PollEvents();
+    return;
+  }
+
+  events.clear();
+  global_events.clear();
+  glfwWaitEventsTimeout(double_duration_seconds(timeout).count());
+  SortEventsByWindow();
+}
+
 bool IsImGuiRelevantEvent(const GlfwEvent& event) {
   return event.Is<GlfwEvent::WindowFocusChange>()
       || event.Is<GlfwEvent::MouseEnterChange>()
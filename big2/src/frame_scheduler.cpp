@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/frame_scheduler.h>
+#include <algorithm>
+#include <iterator>
+
+namespace big2 {
+
+void FrameScheduler::Enqueue(std::string_view name, std::function<void()> work, Priority priority, duration estimated_cost) {
+  items_.push_back(Item{
+      .name = std::string(name),
+      .work = std::move(work),
+      .priority = priority,
+      .estimated_cost = estimated_cost,
+      .sequence = next_sequence_++,
+  });
+}
+
+std::size_t FrameScheduler::Execute(duration budget) {
+  if (items_.empty()) {
+    return 0;
+  }
+
+  const clock::time_point deadline = clock::now() + budget;
+
+  // Work enqueued by the executed items should wait for the next frame so we take the current queue out.
+  std::vector<Item> candidates = std::move(items_);
+  items_.clear();
+
+  std::sort(candidates.begin(), candidates.end(), [](const Item &left, const Item &right) {
+    if (left.priority != right.priority) {
+      return left.priority > right.priority;
+    }
+    return left.sequence < right.sequence;
+  });
+
+  std::vector<Item> deferred;
+  std::size_t executed_count = 0;
+  for (Item &item : candidates) {
+    const clock::time_point start = clock::now();
+    const bool fits_budget = start + GetExpectedCost(item) <= deadline;
+    const bool is_starving = item.deferred_frames >= max_deferred_frames_;
+
+    if (!fits_budget && !is_starving) {
+      item.deferred_frames++;
+      deferred.push_back(std::move(item));
+      continue;
+    }
+
+    item.work();
+    LearnCost(item.name, clock::now() - start);
+    executed_count++;
+  }
+
+  // Keep the original enqueue order so that newly added items are behind the deferred ones.
+  std::move(items_.begin(), items_.end(), std::back_inserter(deferred));
+  items_ = std::move(deferred);
+  return executed_count;
+}
+
+FrameScheduler::duration FrameScheduler::GetLearnedCost(std::string_view name) const {
+  auto it = learned_costs_.find(std::string(name));
+  return it != learned_costs_.end() ? it->second : duration::zero();
+}
+
+FrameScheduler::duration FrameScheduler::GetExpectedCost(const Item &item) const {
+  auto it = learned_costs_.find(item.name);
+  return it != learned_costs_.end() ? it->second : item.estimated_cost;
+}
+
+void FrameScheduler::LearnCost(const std::string &name, duration measured_cost) {
+  auto [it, inserted] = learned_costs_.try_emplace(name, measured_cost);
+  if (!inserted) {
+    // Exponential moving average that favours history so that a single spike doesn't starve the item.
+    it->second = (it->second * 3 + measured_cost) / 4;
+  }
+}
+
+}
@@ -0,0 +1,66 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/hash.h>
+#include <array>
+#include <bit>
+#include <cstring>
+
+namespace big2 {
+
+static constexpr std::uint64_t kHashBytesPrime1 = 0x9e3779b185ebca87ull;
+static constexpr std::uint64_t kHashBytesPrime2 = 0xc2b2ae3d27d4eb4full;
+static constexpr std::uint64_t kHashBytesPrime3 = 0x165667b19e3779f9ull;
+static constexpr std::size_t kHashBytesLaneCount = 4;
+static constexpr std::size_t kHashBytesBlockSize = kHashBytesLaneCount * sizeof(std::uint64_t);
+
+static std::uint64_t ReadWord(const std::byte *bytes) {
+  std::uint64_t word = 0;
+  std::memcpy(&word, bytes, sizeof(word));
+  return word;
+}
+
+static std::uint64_t MixWord(std::uint64_t lane, std::uint64_t word) {
+  lane += word * kHashBytesPrime2;
+  return std::rotl(lane, 31) * kHashBytesPrime1;
+}
+
+std::uint64_t HashBytes(std::span<const std::byte> bytes, std::uint64_t seed) {
+  const std::byte *data = bytes.data();
+  const std::size_t size = bytes.size();
+  std::size_t offset = 0;
+  std::uint64_t hash = seed + kHashBytesPrime3;
+
+  if (size >= kHashBytesBlockSize) {
+    std::array<std::uint64_t, kHashBytesLaneCount> lanes{seed + kHashBytesPrime1 + kHashBytesPrime2, seed + kHashBytesPrime2, seed, seed - kHashBytesPrime1};
+    for (; offset + kHashBytesBlockSize <= size; offset += kHashBytesBlockSize) {
+      for (std::size_t lane = 0; lane < kHashBytesLaneCount; ++lane) {
+        lanes[lane] = MixWord(lanes[lane], ReadWord(data + offset + lane * sizeof(std::uint64_t)));
+      }
+    }
+
+    hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+    for (const std::uint64_t lane : lanes) {
+      hash = (hash ^ MixWord(0, lane)) * kHashBytesPrime1 + kHashBytesPrime3;
+    }
+  }
+
+  hash += size;
+  for (; offset + sizeof(std::uint64_t) <= size; offset += sizeof(std::uint64_t)) {
+    hash = std::rotl(hash ^ MixWord(0, ReadWord(data + offset)), 27) * kHashBytesPrime1 + kHashBytesPrime3;
+  }
+  for (; offset < size; ++offset) {
+    hash = std::rotl(hash ^ (static_cast<std::uint64_t>(data[offset]) * kHashBytesPrime3), 11) * kHashBytesPrime1;
+  }
+
+  // Spreads the last bytes over the whole hash
+  hash ^= hash >> 33;
+  hash *= kHashBytesPrime2;
+  hash ^= hash >> 29;
+  hash *= kHashBytesPrime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+}
@@ -6,26 +6,199 @@
 #ifndef BIG2_STACK_ID_MANAGER_H_
 #define BIG2_STACK_ID_MANAGER_H_
 
-#include <set>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <optional>
 #include <type_traits>
-#include <functional>
-#include <typeinfo>
-#include <numeric>
+#include <vector>
 #include <big2/asserts.h>
 #include <big2/macros.h>
 #include <concepts>
-#include <execution>
 
 namespace big2 {
 
+namespace detail {
+
+/**
+ * @brief The layout of a two-level bitset that has a bit for every id in [0, max_value).
+ * @details Every 64 ids share a word and every 64 words share a summary word that marks which of them are full,
+ * so finding a free id only looks at a summary word and a single id word.
+ */
+template<std::integral T, T max_value>
+struct IdBitsetLayout {
+  static_assert(max_value > 0, "The id range can't be empty");
+  static_assert(static_cast<std::uint64_t>(max_value) <= (std::uint64_t{1} << 24), "The id range is too big to keep a bit for every id");
+
+  using word_type = std::uint64_t;
+
+  static constexpr std::size_t kBitsPerWord = std::numeric_limits<word_type>::digits;
+  static constexpr std::size_t kIdCount = static_cast<std::size_t>(max_value);
+  static constexpr std::size_t kWordCount = (kIdCount + kBitsPerWord - 1) / kBitsPerWord;
+  static constexpr std::size_t kSummaryWordCount = (kWordCount + kBitsPerWord - 1) / kBitsPerWord;
+  static constexpr word_type kFullWord = std::numeric_limits<word_type>::max();
+
+  /**
+   * @brief Bits after the last id in the last word. They are kept reserved so the last word can become full.
+   */
+  static constexpr word_type kTailMask = kIdCount % kBitsPerWord == 0 ? 0 : kFullWord << (kIdCount % kBitsPerWord);
+
+  static constexpr bool IsInRange(T value) {
+    if constexpr (std::is_signed_v<T>) {
+      if (value < 0) {
+        return false;
+      }
+    }
+    return static_cast<std::size_t>(value) < kIdCount;
+  }
+
+  static constexpr std::size_t GetWordIndex(std::size_t id) { return id / kBitsPerWord; }
+  static constexpr word_type GetBit(std::size_t id) { return word_type{1} << (id % kBitsPerWord); }
+};
+
+}
+
+/**
+ * @brief Reserves and frees integer ids in O(1) by always giving out the smallest free id.
+ * @details Ids are in the range [0, max_value). max_value itself is returned when no ids are left.
+ * This class is not thread-safe, use AtomicIdManager if ids are reserved from multiple threads.
+ */
 template<std::integral T, T max_value = std::numeric_limits<T>::max()>
 class IdManager {
+  using layout = detail::IdBitsetLayout<T, max_value>;
+  using word_type = typename layout::word_type;
+
+ public:
+  IdManager() {
+    words_.back() = layout::kTailMask;
+  }
+
+  [[nodiscard]] T Reserve() {
+    for (std::size_t summary_index = 0; summary_index < layout::kSummaryWordCount; summary_index++) {
+      const word_type summary = full_words_[summary_index];
+      if (summary == layout::kFullWord) {
+        continue;
+      }
+
+      const std::size_t word_index = summary_index * layout::kBitsPerWord + std::countr_one(summary);
+      if (word_index >= layout::kWordCount) {
+        break;
+      }
+
+      const auto id = static_cast<T>(word_index * layout::kBitsPerWord + std::countr_one(words_[word_index]));
+      Reserve(id);
+      return id;
+    }
+
+    big2::Validate(false, "Cannot reserve an ID since all IDs are taken");
+    return max_value;
+  }
+
+  void Reserve(T value) {
+    if (!big2::SoftValidate(IsInRange(value) && IsFree(value), "Cannot reserve an id that is already reserved!")) {
+      return;
+    }
+
+    const std::size_t word_index = layout::GetWordIndex(static_cast<std::size_t>(value));
+    words_[word_index] |= layout::GetBit(static_cast<std::size_t>(value));
+    if (words_[word_index] == layout::kFullWord) {
+      full_words_[layout::GetWordIndex(word_index)] |= layout::GetBit(word_index);
+    }
+    reserved_count_++;
+  }
+
+  void Free(T value) {
+    if (!IsInRange(value) || IsFree(value)) {
+      return;
+    }
+
+    const std::size_t word_index = layout::GetWordIndex(static_cast<std::size_t>(value));
+    words_[word_index] &= ~layout::GetBit(static_cast<std::size_t>(value));
+    full_words_[layout::GetWordIndex(word_index)] &= ~layout::GetBit(word_index);
+    reserved_count_--;
+  }
+
+  [[nodiscard]] bool IsFree(T value) const {
+    return !IsReserved(value);
+  }
+
+  [[nodiscard]] bool IsReserved(T value) const {
+    return IsInRange(value) && (words_[layout::GetWordIndex(static_cast<std::size_t>(value))] & layout::GetBit(static_cast<std::size_t>(value))) != 0;
+  }
+
+  [[nodiscard]] std::size_t GetReservedCount() const {
+    return reserved_count_;
+  }
+
+  /**
+   * @brief Calls the function for every reserved id in ascending order without allocating.
+   */
+  template<std::invocable<T> TFunction>
+  void ForEachReserved(TFunction &&function) const {
+    for (std::size_t word_index = 0; word_index < layout::kWordCount; word_index++) {
+      word_type word = words_[word_index];
+      if (word_index == layout::kWordCount - 1) {
+        word &= ~layout::kTailMask;
+      }
+
+      while (word != 0) {
+        function(static_cast<T>(word_index * layout::kBitsPerWord + std::countr_zero(word)));
+        word &= word - 1;
+      }
+    }
+  }
+
+  [[nodiscard]] std::vector<T> GetReservedIds() const {
+    std::vector<T> result;
+    result.reserve(reserved_count_);
+    ForEachReserved([&result](T id) { result.push_back(id); });
+    return result;
+  }
+
+ private:
+  [[nodiscard]] static bool IsInRange(T value) {
+    return layout::IsInRange(value);
+  }
+
+  std::array<word_type, layout::kWordCount> words_{};
+  std::array<word_type, layout::kSummaryWordCount> full_words_{};
+  std::size_t reserved_count_ = 0;
+};
+
+/**
+ * @brief A lock-free version of IdManager that can reserve and free ids from any thread.
+ * @details Ids are claimed with a compare-and-swap on their word. The summary of full words is only a hint
+ * that lets Reserve() skip full words, so a thread may occasionally look at a word that was just filled and move on.
+ */
+template<std::integral T, T max_value = std::numeric_limits<T>::max()>
+class AtomicIdManager {
+  using layout = detail::IdBitsetLayout<T, max_value>;
+  using word_type = typename layout::word_type;
+
  public:
+  AtomicIdManager() {
+    words_.back().store(layout::kTailMask, std::memory_order_relaxed);
+  }
+
   [[nodiscard]] T Reserve() {
-    for(T current_id = 0; current_id < max_value; current_id++) {
-      if(IsFree(current_id)) {
-        Reserve(current_id);
-        return current_id;
+    for (std::size_t summary_index = 0; summary_index < layout::kSummaryWordCount; summary_index++) {
+      word_type summary = full_words_[summary_index].load(std::memory_order_acquire);
+      while (summary != layout::kFullWord) {
+        const std::size_t summary_bit = std::countr_one(summary);
+        const std::size_t word_index = summary_index * layout::kBitsPerWord + summary_bit;
+        if (word_index >= layout::kWordCount) {
+          break;
+        }
+
+        std::optional<T> id = TryReserveInWord(word_index);
+        if (id.has_value()) {
+          return id.value();
+        }
+
+        // The word got full while looking at it so the next one is tried
+        summary |= word_type{1} << summary_bit;
       }
     }
 
@@ -34,28 +207,113 @@ class IdManager {
   }
 
   void Reserve(T value) {
-    big2::SoftValidate(IsFree(value), "Cannot reserve a new id since all id's are reserved!");
-    ids_.insert(value);
+    if (!big2::SoftValidate(IsInRange(value), "Cannot reserve an id that is out of range!")) {
+      return;
+    }
+
+    const std::size_t word_index = layout::GetWordIndex(static_cast<std::size_t>(value));
+    const word_type bit = layout::GetBit(static_cast<std::size_t>(value));
+    const word_type previous = words_[word_index].fetch_or(bit, std::memory_order_acq_rel);
+    if (!big2::SoftValidate((previous & bit) == 0, "Cannot reserve an id that is already reserved!")) {
+      return;
+    }
+
+    OnReserved(word_index, previous | bit);
   }
 
   void Free(T value) {
-    ids_.erase(value);
+    if (!IsInRange(value)) {
+      return;
+    }
+
+    const std::size_t word_index = layout::GetWordIndex(static_cast<std::size_t>(value));
+    const word_type bit = layout::GetBit(static_cast<std::size_t>(value));
+    const word_type previous = words_[word_index].fetch_and(~bit, std::memory_order_acq_rel);
+    if ((previous & bit) == 0) {
+      return;
+    }
+
+    full_words_[layout::GetWordIndex(word_index)].fetch_and(~layout::GetBit(word_index), std::memory_order_acq_rel);
+    reserved_count_.fetch_sub(1, std::memory_order_relaxed);
   }
 
   [[nodiscard]] bool IsFree(T value) const {
-    return !ids_.contains(value);
+    return !IsReserved(value);
   }
 
   [[nodiscard]] bool IsReserved(T value) const {
-    return !IsFree(value);
+    return IsInRange(value)
+        && (words_[layout::GetWordIndex(static_cast<std::size_t>(value))].load(std::memory_order_acquire) & layout::GetBit(static_cast<std::size_t>(value))) != 0;
+  }
+
+  [[nodiscard]] std::size_t GetReservedCount() const {
+    return reserved_count_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Calls the function for every reserved id in ascending order without allocating.
+   * @details Ids reserved or freed by other threads during the call may or may not be reported.
+   */
+  template<std::invocable<T> TFunction>
+  void ForEachReserved(TFunction &&function) const {
+    for (std::size_t word_index = 0; word_index < layout::kWordCount; word_index++) {
+      word_type word = words_[word_index].load(std::memory_order_acquire);
+      if (word_index == layout::kWordCount - 1) {
+        word &= ~layout::kTailMask;
+      }
+
+      while (word != 0) {
+        function(static_cast<T>(word_index * layout::kBitsPerWord + std::countr_zero(word)));
+        word &= word - 1;
+      }
+    }
   }
 
   [[nodiscard]] std::vector<T> GetReservedIds() const {
-    return std::vector<T>(ids_.begin(), ids_.end());
+    std::vector<T> result;
+    result.reserve(GetReservedCount());
+    ForEachReserved([&result](T id) { result.push_back(id); });
+    return result;
   }
 
  private:
-  std::set<T> ids_;
+  [[nodiscard]] static bool IsInRange(T value) {
+    return layout::IsInRange(value);
+  }
+
+  [[nodiscard]] std::optional<T> TryReserveInWord(std::size_t word_index) {
+    std::atomic<word_type> &word = words_[word_index];
+    word_type current = word.load(std::memory_order_acquire);
+    while (current != layout::kFullWord) {
+      const word_type bit = word_type{1} << std::countr_one(current);
+      if (word.compare_exchange_weak(current, current | bit, std::memory_order_acq_rel, std::memory_order_acquire)) {
+        OnReserved(word_index, current | bit);
+        return static_cast<T>(word_index * layout::kBitsPerWord + std::countr_zero(bit));
+      }
+    }
+
+    return {};
+  }
+
+  void OnReserved(std::size_t word_index, word_type new_word) {
+    reserved_count_.fetch_add(1, std::memory_order_relaxed);
+    if (new_word != layout::kFullWord) {
+      return;
+    }
+
+    std::atomic<word_type> &summary = full_words_[layout::GetWordIndex(word_index)];
+    const word_type summary_bit = layout::GetBit(word_index);
+    summary.fetch_or(summary_bit, std::memory_order_acq_rel);
+
+    // An id could have been freed before the summary was updated, in which case the hint is taken back
+    if (words_[word_index].load(std::memory_order_acquire) != layout::kFullWord) {
+      summary.fetch_and(~summary_bit, std::memory_order_acq_rel);
+    }
+  }
+
+  std::array<std::atomic<word_type>, layout::kWordCount> words_{};
+  std::array<std::atomic<word_type>, layout::kSummaryWordCount> full_words_{};
+  std::atomic<std::size_t> reserved_count_ = 0;
 };
 
 }
@@ -6,7 +6,6 @@
 
 #if BIG2_IMGUI_ENABLED
 
-#include <big2/algorithm.h>
 #include <big2/event_queue.h>
 #include <big2/app.h>
 #include <gsl/narrow>
@@ -38,39 +37,27 @@ void ImGuiAppExtension::OnWindowCreated(Window& window) {
 
   ImGui::StyleColorsDark();
 
-  contexts_.push_back(context);
+  contexts_.emplace(window.GetWindowHandle(), context);
 }
 void ImGuiAppExtension::OnWindowDestroyed(Window& window) {
   AppExtensionBase::OnWindowDestroyed(window);
-  std::optional<ImGuiContextWrapper> maybe_context = big2::FirstIf<ImGuiContextWrapper>(contexts_.begin(), contexts_.end(), [&window](ImGuiContextWrapper& context) {
-    return context.GetWindow() == window.GetWindowHandle();
-  });
-
-  if(maybe_context.has_value())
-  {
-    maybe_context.value().Dispose();
+  auto it = contexts_.find(window.GetWindowHandle());
+  if (it != contexts_.end()) {
+    it->second.Dispose();
+    contexts_.erase(it);
   }
-
-  std::erase_if(contexts_,
-                [window](ImGuiContextWrapper &context) {
-                  return context.GetWindow() == window.GetWindowHandle();
-                });
 }
 
 void ImGuiAppExtension::OnUpdate(std::float_t dt) {
   AppExtensionBase::OnUpdate(dt);
 
   for(Window& window : app_->GetWindows()) {
-    std::optional<ImGuiContextWrapper> maybe_context = big2::FirstIf<ImGuiContextWrapper>(contexts_.begin(), contexts_.end(), [&window](ImGuiContextWrapper& context) {
-      return context.GetWindow() == window.GetWindowHandle();
-    });
-
-    if(!maybe_context.has_value())
-    {
-      return;
+    auto it = contexts_.find(window.GetWindowHandle());
+    if (it == contexts_.end()) {
+      continue;
     }
 
-    ImGui::SetCurrentContext(maybe_context.value().GetContext());
+    ImGui::SetCurrentContext(it->second.GetContext());
     big2::GlfwEventQueue::UpdateImGuiEvents(window.GetWindowHandle());
   }
 }
@@ -12,23 +12,76 @@
 #include <bx/math.h>
 #include <cmath>
 #include <algorithm>
+#include <bit>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
 #include <gsl/gsl>
 #include <big2/asserts.h>
 #include <big2/macros.h>
 #include <glm/glm.hpp>
 #include <big2/bgfx/bgfx_utils.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_initialization_scoped.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
+#include <big2/bgfx/bgfx_program_registry.h>
+#include <big2/bgfx/bgfx_pipeline_warmup.h>
+#include <big2/bgfx/bgfx_vertex_layout.h>
+#include <big2/bgfx/bgfx_render_state.h>
+#include <big2/bgfx/bgfx_uniform_registry.h>
 #include <big2/glfw/glfw_utils.h>
+#include <big2/hash.h>
 #include <big2/void_ptr.h>
 
-constexpr const std::uint64_t kState =
-    BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A | BGFX_STATE_MSAA | BGFX_STATE_BLEND_FUNC(BGFX_STATE_BLEND_SRC_ALPHA, BGFX_STATE_BLEND_INV_SRC_ALPHA);
+BIG2_VERTEX_LAYOUT(ImDrawVert,
+                   BIG2_VERTEX_ATTRIBUTE(ImDrawVert, pos, bgfx::Attrib::Position, 2, bgfx::AttribType::Float, false),
+                   BIG2_VERTEX_ATTRIBUTE(ImDrawVert, uv, bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float, false),
+                   BIG2_VERTEX_ATTRIBUTE(ImDrawVert, col, bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true));
+
+constexpr const std::uint64_t kState = big2::RenderState()
+    .WithColorWrite()
+    .WithMsaa()
+    .WithBlend(big2::BlendFactor::SourceAlpha, big2::BlendFactor::InverseSourceAlpha);
+
+struct DynamicGeometryBuffers {
+  bgfx::DynamicVertexBufferHandle vertex_buffer = BGFX_INVALID_HANDLE;
+  bgfx::DynamicIndexBufferHandle index_buffer = BGFX_INVALID_HANDLE;
+  std::uint32_t vertex_capacity = 0;
+  std::uint32_t index_capacity = 0;
+};
+
+/**
+ * @brief Dynamic buffers for the draw data that doesn't fit in the transient buffers.
+ * @details Each draw data of a frame gets its own entry since updating a dynamic buffer again in the same frame
+ * would change what the earlier draws use. The entries are reused in the next frames and grow to fit.
+ */
+struct DynamicGeometryRing {
+  std::vector<DynamicGeometryBuffers> entries;
+  std::size_t next_entry = 0;
+  std::uint32_t frame = 0;
+  int imgui_frame = -1;
+  bool has_warned = false;
+};
+
+/**
+ * @brief Keeps the geometry of a draw data that stays the same over frames, so only the submits have to be repeated.
+ * @details The geometry is copied into the buffers once it was the same in two frames in a row, until then it
+ * goes through the transient buffers so a UI that changes every frame doesn't pay for the copy.
+ */
+struct DrawDataCache {
+  std::uint64_t hash = 0;
+  bool is_uploaded = false;
+  DynamicGeometryBuffers buffers;
+};
 
 struct BackendRendererData {
   bgfx::ViewId view_id = 0;
   bgfx::TextureHandle font_texture_handle = BGFX_INVALID_HANDLE;
-  bgfx::ProgramHandle shader_handle = BGFX_INVALID_HANDLE;
+  big2::ProgramReference program;
   bgfx::UniformHandle texture_location_handle = BGFX_INVALID_HANDLE;
-  bgfx::VertexLayout vertex_layout;
+  DynamicGeometryRing dynamic_geometry;
+  DrawDataCache draw_data_cache;
 };
 
 struct Rgba32TextureData {
@@ -55,60 +108,290 @@ static const bgfx::EmbeddedShader EmbeddedShaders[] =
         BGFX_EMBEDDED_SHADER_END()
     };
 
-void ExecuteRenderCommands(const ImDrawData *draw_data, unsigned short view_id, bgfx::ProgramHandle program, bgfx::UniformHandle texture_location, const bgfx::VertexLayout layout, const glm::vec2 frame_location, glm::vec2 frame_size) {
-  const bgfx::Caps *caps = bgfx::getCaps();
+struct CachedScissor {
+  glm::u16vec4 rect;
+  std::uint16_t cache;
+};
 
-  float_t orthographic_view[16];
-  bx::mtxOrtho(orthographic_view, frame_location.x, frame_location.x + frame_size.x, frame_location.y + frame_size.y, frame_location.y, 0.0f, 1000.0f, 0.0f, caps->homogeneousDepth);
-  bgfx::setViewTransform(view_id, nullptr, orthographic_view);
-  bgfx::setViewRect(view_id, 0, 0, gsl::narrow_cast<uint16_t>(frame_size.x), gsl::narrow_cast<uint16_t>(frame_size.y));
+/**
+ * @brief Converts a clip rectangle to the scissor of the frame.
+ * @return Nothing if the rectangle is completely outside of the frame.
+ */
+static std::optional<glm::u16vec4> GetScissor(const ImVec4 &clip_rect, const glm::vec2 frame_location, const glm::vec2 frame_size) {
+  const glm::vec2 min = glm::max(glm::vec2(clip_rect.x, clip_rect.y) - frame_location, glm::vec2(0.0f));
+  const glm::vec2 max = glm::min(glm::vec2(clip_rect.z, clip_rect.w) - frame_location, glm::min(frame_size, glm::vec2(65535.0f)));
+  if (max.x <= min.x || max.y <= min.y) {
+    return std::nullopt;
+  }
+  return glm::u16vec4(glm::u16vec2(min), glm::u16vec2(max - min));
+}
+
+/**
+ * @brief Sets the scissor, reusing the entry of BGFX's scissor cache if the same rectangle was already used in this frame.
+ */
+static void SetScissor(std::vector<CachedScissor> &scissors, const glm::u16vec4 &rect) {
+  auto it = std::find_if(scissors.begin(), scissors.end(), [&rect](const CachedScissor &scissor) { return scissor.rect == rect; });
+  if (it != scissors.end()) {
+    bgfx::setScissor(it->cache);
+    return;
+  }
+  scissors.push_back({rect, bgfx::setScissor(rect.x, rect.y, rect.z, rect.w)});
+}
+
+/**
+ * @brief Checks if the next command draws right after the command with the same texture, clipping and vertices.
+ */
+static bool CanMergeDrawCommands(const ImDrawCmd &command, const ImDrawCmd &next) {
+  return next.UserCallback == nullptr
+      && next.TextureId == command.TextureId
+      && next.VtxOffset == command.VtxOffset
+      && next.IdxOffset == command.IdxOffset + command.ElemCount
+      && next.ClipRect.x == command.ClipRect.x && next.ClipRect.y == command.ClipRect.y
+      && next.ClipRect.z == command.ClipRect.z && next.ClipRect.w == command.ClipRect.w;
+}
+
+/**
+ * @brief The buffers all command lists of a draw data were copied into, either transient or dynamic ones.
+ */
+struct DrawDataGeometry {
+  bgfx::TransientVertexBuffer transient_vertex_buffer{};
+  bgfx::TransientIndexBuffer transient_index_buffer{};
+  const DynamicGeometryBuffers *dynamic_buffers = nullptr;
+  std::uint32_t vertex_count = 0;
+
+  void SetVertexBuffer(std::uint32_t start_vertex) const {
+    if (dynamic_buffers != nullptr) {
+      bgfx::setVertexBuffer(0, dynamic_buffers->vertex_buffer, start_vertex, vertex_count - start_vertex);
+    } else {
+      bgfx::setVertexBuffer(0, &transient_vertex_buffer, start_vertex, vertex_count - start_vertex);
+    }
+  }
 
-  // Render command lists
+  void SetIndexBuffer(std::uint32_t first_index, std::uint32_t index_count) const {
+    if (dynamic_buffers != nullptr) {
+      bgfx::setIndexBuffer(dynamic_buffers->index_buffer, first_index, index_count);
+    } else {
+      bgfx::setIndexBuffer(&transient_index_buffer, first_index, index_count);
+    }
+  }
+};
+
+static void CopyDrawLists(const ImDrawData *draw_data, ImDrawVert *vertices, ImDrawIdx *indices) {
   for (int n = 0; n < draw_data->CmdListsCount; n++) {
     const ImDrawList *command_list = draw_data->CmdLists[n];
+    std::memcpy(vertices, command_list->VtxBuffer.Data, command_list->VtxBuffer.size_in_bytes());
+    std::memcpy(indices, command_list->IdxBuffer.Data, command_list->IdxBuffer.size_in_bytes());
+    vertices += command_list->VtxBuffer.Size;
+    indices += command_list->IdxBuffer.Size;
+  }
+}
+
+static void ReserveDynamicGeometryBuffers(DynamicGeometryBuffers &buffers, const bgfx::VertexLayout &layout, std::uint32_t vertex_count, std::uint32_t index_count) {
+  if (buffers.vertex_capacity < vertex_count) {
+    big2::DestroyDeferred(buffers.vertex_buffer);
+    buffers.vertex_capacity = std::bit_ceil(vertex_count);
+    buffers.vertex_buffer = big2::TrackResource(bgfx::createDynamicVertexBuffer(buffers.vertex_capacity, layout), std::uint64_t{buffers.vertex_capacity} * layout.getStride());
+  }
+
+  if (buffers.index_capacity < index_count) {
+    big2::DestroyDeferred(buffers.index_buffer);
+    buffers.index_capacity = std::bit_ceil(index_count);
+    buffers.index_buffer = big2::TrackResource(bgfx::createDynamicIndexBuffer(buffers.index_capacity, sizeof(ImDrawIdx) == 4 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE),
+                                               std::uint64_t{buffers.index_capacity} * sizeof(ImDrawIdx));
+  }
+}
+
+static void DestroyDynamicGeometryBuffers(DynamicGeometryBuffers &buffers) {
+  big2::DestroyDeferred(buffers.vertex_buffer);
+  big2::DestroyDeferred(buffers.index_buffer);
+  buffers = {};
+}
+
+static void UpdateDynamicGeometryBuffers(const ImDrawData *draw_data, const DynamicGeometryBuffers &buffers, const bgfx::VertexLayout &layout) {
+  const bgfx::Memory *vertex_memory = bgfx::alloc(static_cast<std::uint32_t>(draw_data->TotalVtxCount) * layout.getStride());
+  const bgfx::Memory *index_memory = bgfx::alloc(static_cast<std::uint32_t>(draw_data->TotalIdxCount) * sizeof(ImDrawIdx));
+  CopyDrawLists(draw_data, reinterpret_cast<ImDrawVert *>(vertex_memory->data), reinterpret_cast<ImDrawIdx *>(index_memory->data));
+  bgfx::update(buffers.vertex_buffer, 0, vertex_memory);
+  bgfx::update(buffers.index_buffer, 0, index_memory);
+}
+
+static const DynamicGeometryBuffers &AcquireDynamicGeometryBuffers(DynamicGeometryRing &ring, const bgfx::VertexLayout &layout, std::uint32_t vertex_count, std::uint32_t index_count) {
+  // Apps that call bgfx::frame() instead of big2::Frame() don't advance the submitted frame count,
+  // ImGui starts a frame for every one of theirs though
+  const std::uint32_t frame = big2::GetSubmittedFrameCount();
+  if (const int imgui_frame = ImGui::GetFrameCount(); frame != ring.frame || imgui_frame != ring.imgui_frame) {
+    ring.frame = frame;
+    ring.imgui_frame = imgui_frame;
+    ring.next_entry = 0;
+  }
+
+  if (ring.next_entry == ring.entries.size()) {
+    ring.entries.emplace_back();
+  }
+  DynamicGeometryBuffers &buffers = ring.entries[ring.next_entry++];
+  ReserveDynamicGeometryBuffers(buffers, layout, vertex_count, index_count);
+  return buffers;
+}
+
+static void DestroyDynamicGeometryRing(DynamicGeometryRing &ring) {
+  for (DynamicGeometryBuffers &buffers : ring.entries) {
+    DestroyDynamicGeometryBuffers(buffers);
+  }
+  ring.entries.clear();
+  ring.next_entry = 0;
+}
 
-    uint32_t requested_vertices_count = static_cast<uint32_t>(command_list->VtxBuffer.size());
-    uint32_t requested_indices_count = static_cast<uint32_t>(command_list->IdxBuffer.size());
+/**
+ * @brief Hashes the vertices, indices and commands of all command lists.
+ * @return Nothing if a command has a callback, since what callbacks draw can't be known.
+ */
+static std::optional<std::uint64_t> HashDrawData(const ImDrawData *draw_data) {
+  std::uint64_t hash = big2::kHashNameSeed;
+  for (int n = 0; n < draw_data->CmdListsCount; n++) {
+    const ImDrawList *command_list = draw_data->CmdLists[n];
+    for (const ImDrawCmd &draw_command : command_list->CmdBuffer) {
+      if (draw_command.UserCallback != nullptr) {
+        return std::nullopt;
+      }
+    }
 
-    bool has_vb_space = big2::SoftValidate(bgfx::getAvailTransientVertexBuffer(requested_vertices_count, layout) == requested_vertices_count, "Not enough space in vertex transient buffer.");
-    bool has_ib_space = big2::SoftValidate(bgfx::getAvailTransientIndexBuffer(requested_indices_count) == requested_indices_count, "Not enough space in index transient buffer.");
+    // ImDrawCmd zeroes its padding, so the commands can be hashed as memory
+    hash = big2::HashBytes(std::as_bytes(std::span(command_list->VtxBuffer.Data, command_list->VtxBuffer.Size)), hash);
+    hash = big2::HashBytes(std::as_bytes(std::span(command_list->IdxBuffer.Data, command_list->IdxBuffer.Size)), hash);
+    hash = big2::HashBytes(std::as_bytes(std::span(command_list->CmdBuffer.Data, command_list->CmdBuffer.Size)), hash);
+  }
+  return hash;
+}
 
-    if (!has_vb_space || !has_ib_space) {
-      break;
+/**
+ * @brief Copies all command lists into one pair of buffers, transient ones if they fit, the dynamic ring otherwise.
+ * @details Geometry that is the same as in the last frames is taken from the cache without copying it.
+ */
+static void UploadDrawData(const ImDrawData *draw_data, DynamicGeometryRing &ring, DrawDataCache &cache, const bgfx::VertexLayout &layout, DrawDataGeometry &geometry) {
+  const auto vertex_count = static_cast<std::uint32_t>(draw_data->TotalVtxCount);
+  const auto index_count = static_cast<std::uint32_t>(draw_data->TotalIdxCount);
+  geometry.vertex_count = vertex_count;
+
+  const std::optional<std::uint64_t> hash = HashDrawData(draw_data);
+  if (hash.has_value() && *hash == cache.hash) {
+    if (!cache.is_uploaded) {
+      ReserveDynamicGeometryBuffers(cache.buffers, layout, vertex_count, index_count);
+      UpdateDynamicGeometryBuffers(draw_data, cache.buffers, layout);
+      cache.is_uploaded = true;
     }
+    geometry.dynamic_buffers = &cache.buffers;
+    return;
+  }
+  cache.hash = hash.value_or(0);
+  cache.is_uploaded = false;
 
-    bgfx::TransientVertexBuffer transient_vtx_buffer{};
-    bgfx::allocTransientVertexBuffer(&transient_vtx_buffer, requested_vertices_count, layout);
-    bgfx::TransientIndexBuffer transient_idx_buffer{};
-    bgfx::allocTransientIndexBuffer(&transient_idx_buffer, requested_indices_count);
+  if (big2::BgfxInitializationScoped *bgfx_initialization = big2::BgfxInitializationScoped::GetInstance(); bgfx_initialization != nullptr) {
+    bgfx_initialization->RecordTransientBufferUse(vertex_count * layout.getStride(), index_count * sizeof(ImDrawIdx));
+  }
 
-    gsl::span<ImDrawVert> vertices(reinterpret_cast<ImDrawVert *>(transient_vtx_buffer.data), transient_vtx_buffer.size);
-    std::copy(command_list->VtxBuffer.begin(), command_list->VtxBuffer.end(), vertices.begin());
+  if (bgfx::getAvailTransientVertexBuffer(vertex_count, layout) == vertex_count
+      && bgfx::getAvailTransientIndexBuffer(index_count, sizeof(ImDrawIdx) == 4) == index_count) {
+    bgfx::allocTransientVertexBuffer(&geometry.transient_vertex_buffer, vertex_count, layout);
+    bgfx::allocTransientIndexBuffer(&geometry.transient_index_buffer, index_count, sizeof(ImDrawIdx) == 4);
+    CopyDrawLists(draw_data, reinterpret_cast<ImDrawVert *>(geometry.transient_vertex_buffer.data), reinterpret_cast<ImDrawIdx *>(geometry.transient_index_buffer.data));
+    return;
+  }
 
-    gsl::span<ImDrawIdx> indices(reinterpret_cast<ImDrawIdx *>(transient_idx_buffer.data), transient_idx_buffer.size);
-    std::copy(command_list->IdxBuffer.begin(), command_list->IdxBuffer.end(), indices.begin());
+  if (!ring.has_warned) {
+    big2::Warning("The ImGui geometry doesn't fit in the transient buffers, dynamic buffers are used until BGFX is initialized with larger ones");
+    ring.has_warned = true;
+  }
 
-    for (int cmd_i = 0; cmd_i < command_list->CmdBuffer.Size; cmd_i++) {
-      const ImDrawCmd *draw_command = &command_list->CmdBuffer[cmd_i];
+  const DynamicGeometryBuffers &buffers = AcquireDynamicGeometryBuffers(ring, layout, vertex_count, index_count);
+  UpdateDynamicGeometryBuffers(draw_data, buffers, layout);
+  geometry.dynamic_buffers = &buffers;
+}
 
-      if (draw_command->UserCallback) {
-        draw_command->UserCallback(command_list, draw_command);
-      } else {
-        const glm::u16vec2 position(bx::max(draw_command->ClipRect.x - frame_location.x, 0.0f), bx::max(draw_command->ClipRect.y - frame_location.y, 0.0f));
-        const glm::u16vec2 end_position(bx::min(draw_command->ClipRect.z - frame_location.x, 65535.0f), bx::min(draw_command->ClipRect.w - frame_location.y, 65535.0f));
-        const glm::u16vec2 size = end_position - position;
-        bgfx::setScissor(position.x, position.y, size.x, size.y);
+void ExecuteRenderCommands(const ImDrawData *draw_data, unsigned short view_id, bgfx::ProgramHandle program, bgfx::UniformHandle texture_location, const bgfx::VertexLayout &layout, DynamicGeometryRing &dynamic_geometry, DrawDataCache &cache, const glm::vec2 frame_location, glm::vec2 frame_size) {
+  const bgfx::Caps *caps = bgfx::getCaps();
 
-        bgfx::setState(kState);
+  float_t orthographic_view[16];
+  bx::mtxOrtho(orthographic_view, frame_location.x, frame_location.x + frame_size.x, frame_location.y + frame_size.y, frame_location.y, 0.0f, 1000.0f, 0.0f, caps->homogeneousDepth);
+  bgfx::setViewTransform(view_id, nullptr, orthographic_view);
+  bgfx::setViewRect(view_id, 0, 0, gsl::narrow_cast<uint16_t>(frame_size.x), gsl::narrow_cast<uint16_t>(frame_size.y));
 
-        bgfx::TextureHandle texture = {static_cast<uint16_t>(static_cast<uintptr_t>(draw_command->TextureId) & 0xffff)};
+  if (draw_data->TotalVtxCount == 0 || draw_data->TotalIdxCount == 0) {
+    return;
+  }
+
+  // One buffer pair for all command lists, the draws pick their part of it with vertex and index offsets
+  DrawDataGeometry geometry;
+  UploadDrawData(draw_data, dynamic_geometry, cache, layout, geometry);
+
+  // Render command lists, keeping the state, texture and vertex buffer bound between submits while they stay the same
+  std::vector<CachedScissor> scissors;
+  bool is_bound = false;
+  ImTextureID bound_texture{};
+  std::uint32_t bound_start_vertex = 0;
+  glm::u16vec4 bound_scissor{};
+
+  std::uint32_t list_vertex_offset = 0;
+  std::uint32_t list_index_offset = 0;
+  for (int n = 0; n < draw_data->CmdListsCount; n++) {
+    const ImDrawList *command_list = draw_data->CmdLists[n];
 
+    for (int cmd_i = 0; cmd_i < command_list->CmdBuffer.Size;) {
+      const ImDrawCmd &draw_command = command_list->CmdBuffer[cmd_i];
+
+      if (draw_command.UserCallback != nullptr) {
+        // Callbacks may submit draws of their own, so they start from a clean state
+        if (is_bound) {
+          bgfx::discard(BGFX_DISCARD_ALL);
+          is_bound = false;
+        }
+        if (draw_command.UserCallback != ImDrawCallback_ResetRenderState) {
+          draw_command.UserCallback(command_list, &draw_command);
+        }
+        cmd_i++;
+        continue;
+      }
+
+      std::uint32_t element_count = draw_command.ElemCount;
+      for (cmd_i++; cmd_i < command_list->CmdBuffer.Size && CanMergeDrawCommands(command_list->CmdBuffer[cmd_i - 1], command_list->CmdBuffer[cmd_i]); cmd_i++) {
+        element_count += command_list->CmdBuffer[cmd_i].ElemCount;
+      }
+
+      const std::optional<glm::u16vec4> scissor = GetScissor(draw_command.ClipRect, frame_location, frame_size);
+      if (!scissor.has_value() || element_count == 0) {
+        continue;
+      }
+
+      // The indices of a command are relative to its VtxOffset, which lets lists have more vertices than 16-bit indices can address
+      const std::uint32_t start_vertex = list_vertex_offset + draw_command.VtxOffset;
+
+      if (!is_bound) {
+        bgfx::setState(kState);
+      }
+      if (!is_bound || draw_command.TextureId != bound_texture) {
+        bgfx::TextureHandle texture = {static_cast<uint16_t>(static_cast<uintptr_t>(draw_command.TextureId) & 0xffff)};
         bgfx::setTexture(0, texture_location, texture);
-        bgfx::setVertexBuffer(0, &transient_vtx_buffer, 0, requested_vertices_count);
-        bgfx::setIndexBuffer(&transient_idx_buffer, draw_command->IdxOffset, draw_command->ElemCount);
-        bgfx::submit(view_id, program);
+        bound_texture = draw_command.TextureId;
+      }
+      if (!is_bound || start_vertex != bound_start_vertex) {
+        geometry.SetVertexBuffer(start_vertex);
+        bound_start_vertex = start_vertex;
       }
+      if (!is_bound || *scissor != bound_scissor) {
+        SetScissor(scissors, *scissor);
+        bound_scissor = *scissor;
+      }
+
+      geometry.SetIndexBuffer(list_index_offset + draw_command.IdxOffset, element_count);
+      bgfx::submit(view_id, program, 0, BGFX_DISCARD_INDEX_BUFFER);
+      is_bound = true;
     }
+
+    list_vertex_offset += static_cast<std::uint32_t>(command_list->VtxBuffer.Size);
+    list_index_offset += static_cast<std::uint32_t>(command_list->IdxBuffer.Size);
+  }
+
+  if (is_bound) {
+    bgfx::discard(BGFX_DISCARD_ALL);
   }
 }
 
@@ -122,6 +405,7 @@ struct BackendRendererViewportData {
 
   big2::BgfxViewScoped view;
   big2::BgfxFrameBufferScoped frame_buffer;
+  DrawDataCache draw_data_cache;
 };
 
 void ViewportCreateWindow(ImGuiViewport *viewport) {
@@ -138,7 +422,9 @@ void ViewportCreateWindow(ImGuiViewport *viewport) {
 void ViewportDestroyWindow(ImGuiViewport *viewport) {
   big2::VoidPtr data = viewport->RendererUserData;
   if (data.IsValid()) {
-    IM_DELETE<void>(data);
+    BackendRendererViewportData *viewport_data = data.RCast<BackendRendererViewportData>();
+    DestroyDynamicGeometryBuffers(viewport_data->draw_data_cache.buffers);
+    IM_DELETE(viewport_data);
   }
 
   viewport->RendererUserData = nullptr;
@@ -174,9 +460,9 @@ void ViewportRenderWindow(ImGuiViewport *viewport, auto) {
 
   ImGuiIO &io = ImGui::GetIO();
   BackendRendererData *backend_data = ImGui_ImplBgfx_GetBackendData();
-  bgfx::ProgramHandle program = backend_data->shader_handle;
+  bgfx::ProgramHandle program = backend_data->program.Get();
   bgfx::UniformHandle texture_location = backend_data->texture_location_handle;
-  bgfx::VertexLayout layout = backend_data->vertex_layout;
+  const bgfx::VertexLayout &layout = big2::GetVertexLayout<ImDrawVert>();
   const glm::vec2 frame_location(viewport->DrawData->DisplayPos.x, viewport->DrawData->DisplayPos.y);
   const glm::vec2 frame_size(viewport->DrawData->DisplaySize.x * viewport->DrawData->FramebufferScale.x, viewport->DrawData->DisplaySize.y * viewport->DrawData->FramebufferScale.y);
 
@@ -186,7 +472,7 @@ void ViewportRenderWindow(ImGuiViewport *viewport, auto) {
 
   viewport->DrawData->ScaleClipRects(io.DisplayFramebufferScale);
 
-  ExecuteRenderCommands(viewport->DrawData, data->view, program, texture_location, layout, frame_location, frame_size);
+  ExecuteRenderCommands(viewport->DrawData, data->view, program, texture_location, layout, backend_data->dynamic_geometry, data->draw_data_cache, frame_location, frame_size);
 }
 
 void InitializeViewportInterface() {
@@ -210,6 +496,7 @@ void InitializeImGuiIO() {
   big2::Validate(io.BackendRendererUserData == nullptr, "Already initialized a renderer backend!");
   io.BackendRendererUserData = big2::VoidPtr(IM_NEW(BackendRendererData)());
   io.BackendRendererName = "imgui_impl_bgfx";
+  io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
 
 #if defined(IMGUI_HAS_VIEWPORT)
   io.BackendFlags |= ImGuiBackendFlags_RendererHasViewports;
@@ -258,9 +545,9 @@ void ImGui_ImplBgfx_NewFrame() {
 void ImGui_ImplBgfx_RenderDrawData(ImDrawData *draw_data) {
   gsl::not_null<BackendRendererData *> backend_data = ImGui_ImplBgfx_GetBackendData();
   bgfx::ViewId view_id = backend_data->view_id;
-  bgfx::ProgramHandle program = backend_data->shader_handle;
+  bgfx::ProgramHandle program = backend_data->program.Get();
   bgfx::UniformHandle texture_location = backend_data->texture_location_handle;
-  bgfx::VertexLayout layout = backend_data->vertex_layout;
+  const bgfx::VertexLayout &layout = big2::GetVertexLayout<ImDrawVert>();
 
   // Avoid rendering when minimized, scale coordinates for retina displays
   // (screen coordinates != framebuffer coordinates)
@@ -280,7 +567,7 @@ void ImGui_ImplBgfx_RenderDrawData(ImDrawData *draw_data) {
 
   draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
-  ExecuteRenderCommands(draw_data, view_id, program, texture_location, layout, frame_location, frame_size);
+  ExecuteRenderCommands(draw_data, view_id, program, texture_location, layout, backend_data->dynamic_geometry, backend_data->draw_data_cache, frame_location, frame_size);
 }
 
 Rgba32TextureData GetTextureData() {
@@ -302,7 +589,9 @@ bool ImGui_ImplBgfx_CreateFontsTexture() {
   constexpr std::uint64_t kFlags = 0;
 
   const bgfx::Memory *data = bgfx::copy(texture_data.bytes, static_cast<std::uint32_t>(texture_data.GetBytesCount()));
-  backend_data->font_texture_handle = bgfx::createTexture2D(texture_data.size.x, texture_data.size.y, kHasMips, kLayersCount, bgfx::TextureFormat::BGRA8, kFlags, data);
+  backend_data->font_texture_handle = big2::TrackResource(
+      bgfx::createTexture2D(texture_data.size.x, texture_data.size.y, kHasMips, kLayersCount, bgfx::TextureFormat::BGRA8, kFlags, data),
+      big2::EstimateTextureBytes(texture_data.size, kHasMips, kLayersCount, bgfx::TextureFormat::BGRA8));
 
   ImGuiIO &io = ImGui::GetIO();
   io.Fonts->SetTexID(static_cast<ImTextureID>(backend_data->font_texture_handle.idx));
@@ -314,7 +603,7 @@ void ImGui_ImplBgfx_DestroyFontsTexture() {
   gsl::not_null<BackendRendererData *> backend_data = ImGui_ImplBgfx_GetBackendData();
 
   if (isValid(backend_data->font_texture_handle)) {
-    bgfx::destroy(backend_data->font_texture_handle);
+    big2::DestroyDeferred(backend_data->font_texture_handle);
     ImGui::GetIO().Fonts->SetTexID(0);
     backend_data->font_texture_handle = BGFX_INVALID_HANDLE;
   }
@@ -323,20 +612,14 @@ void ImGui_ImplBgfx_DestroyFontsTexture() {
 bool ImGui_ImplBgfx_CreateDeviceObjects() {
   gsl::not_null<BackendRendererData *> backend_data = ImGui_ImplBgfx_GetBackendData();
 
-  bgfx::RendererType::Enum type = bgfx::getRendererType();
-  backend_data->shader_handle = bgfx::createProgram(
-      bgfx::createEmbeddedShader(EmbeddedShaders, type, "vs_ocornut_imgui"),
-      bgfx::createEmbeddedShader(EmbeddedShaders, type, "fs_ocornut_imgui"),
-      true
-  );
+  // Shared by all ImGui contexts and only created once something is drawn
+  big2::RegisterEmbeddedShaders(EmbeddedShaders);
+  backend_data->program = big2::GetProgram("vs_ocornut_imgui", "fs_ocornut_imgui");
 
-  backend_data->vertex_layout.begin()
-      .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
-      .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
-      .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
-      .end();
+  big2::RecordPipeline(backend_data->program, kState, big2::GetVertexLayout<ImDrawVert>());
 
-  backend_data->texture_location_handle = bgfx::createUniform("g_AttribLocationTex", bgfx::UniformType::Sampler);
+  // Shared by all ImGui contexts, destroyed together with BGFX
+  backend_data->texture_location_handle = big2::GetUniform("g_AttribLocationTex", bgfx::UniformType::Sampler);
 
   ImGui_ImplBgfx_CreateFontsTexture();
 
@@ -346,8 +629,11 @@ bool ImGui_ImplBgfx_CreateDeviceObjects() {
 void ImGui_ImplBgfx_DestroyDeviceObjects() {
   gsl::not_null<BackendRendererData *> backend_data = ImGui_ImplBgfx_GetBackendData();
 
-  bgfx::destroy(backend_data->texture_location_handle);
-  bgfx::destroy(backend_data->shader_handle);
+  backend_data->texture_location_handle = BGFX_INVALID_HANDLE;
+  backend_data->program.Reset();
+  DestroyDynamicGeometryRing(backend_data->dynamic_geometry);
+  DestroyDynamicGeometryBuffers(backend_data->draw_data_cache.buffers);
+  backend_data->draw_data_cache = {};
 
   ImGui_ImplBgfx_DestroyFontsTexture();
 }
@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/main_thread_queue.h>
+#include <GLFW/glfw3.h>
+
+namespace big2 {
+
+// This is an intrusive MPSC queue as described by Dmitry Vyukov.
+// Producers only exchange the head so they never wait on each other and the consumer only touches the tail.
+
+MainThreadQueue::MainThreadQueue() : head_(&stub_), tail_(&stub_) {
+}
+
+MainThreadQueue::~MainThreadQueue() {
+  // Commands that never ran are deleted which breaks the promises of their futures
+  while (Node *node = Pop()) {
+    delete node;
+  }
+}
+
+std::size_t MainThreadQueue::Drain() {
+  std::size_t executed_count = 0;
+  while (Node *node = Pop()) {
+    pending_count_.fetch_sub(1, std::memory_order_acq_rel);
+    node->Run();
+    delete node;
+    executed_count++;
+  }
+
+  return executed_count;
+}
+
+bool MainThreadQueue::HasPendingCommands() const {
+  return pending_count_.load(std::memory_order_acquire) > 0;
+}
+
+void MainThreadQueue::Push(Node *node) {
+  pending_count_.fetch_add(1, std::memory_order_release);
+  PushStub(node);
+  glfwPostEmptyEvent();
+}
+
+void MainThreadQueue::PushStub(Node *node) {
+  node->next.store(nullptr, std::memory_order_relaxed);
+  Node *previous = head_.exchange(node, std::memory_order_acq_rel);
+  previous->next.store(node, std::memory_order_release);
+}
+
+MainThreadQueue::Node *MainThreadQueue::Pop() {
+  Node *tail = tail_;
+  Node *next = tail->next.load(std::memory_order_acquire);
+
+  if (tail == &stub_) {
+    if (next == nullptr) {
+      return nullptr;
+    }
+
+    tail_ = next;
+    tail = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+
+  // A producer has exchanged the head but hasn't linked its node yet, it will be picked up on the next drain
+  if (tail != head_.load(std::memory_order_acquire)) {
+    return nullptr;
+  }
+
+  PushStub(&stub_);
+
+  next = tail->next.load(std::memory_order_acquire);
+  if (next != nullptr) {
+    tail_ = next;
+    return tail;
+  }
+
+  return nullptr;
+}
+
+}
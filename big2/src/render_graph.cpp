@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/render_graph.h>
+#include <big2/asserts.h>
+#include <big2/bgfx/bgfx_utils.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <map>
+#include <optional>
+
+namespace big2 {
+
+// Graphs set the order of all views and hand their targets back at the end of Execute(), so only one runs per frame
+static std::optional<std::uint32_t> executed_frame;
+
+bgfx::TextureHandle RenderPassContext::GetTexture(RenderGraphResource resource) const {
+  big2::Validate(resource.index < graph_.resources_.size(), "Unknown render graph resource");
+  const RenderGraph::Resource &graph_resource = graph_.resources_[resource.index];
+  big2::Validate(graph_resource.target.IsValid(), "Only transient targets that are in use can be sampled");
+  return graph_resource.target.color;
+}
+
+RenderGraphResource RenderGraph::PassBuilder::CreateTarget(std::string name, const RenderTargetDescriptor &descriptor) {
+  big2::Validate(descriptor.size.x > 0 && descriptor.size.y > 0, "Render targets can't be empty");
+  Resource &resource = graph_.resources_.emplace_back();
+  resource.name = std::move(name);
+  resource.descriptor = descriptor;
+  return RenderGraphResource{gsl::narrow_cast<std::uint32_t>(graph_.resources_.size() - 1)};
+}
+
+void RenderGraph::PassBuilder::Read(RenderGraphResource resource) {
+  big2::Validate(resource.index < graph_.resources_.size(), "Unknown render graph resource");
+  big2::Validate(!graph_.resources_[resource.index].is_window, "Windows can't be read by passes");
+  graph_.passes_[pass_index_].reads.push_back(resource.index);
+}
+
+void RenderGraph::PassBuilder::Write(RenderGraphResource resource) {
+  big2::Validate(resource.index < graph_.resources_.size(), "Unknown render graph resource");
+  Pass &pass = graph_.passes_[pass_index_];
+  big2::Validate(pass.write == RenderGraphResource::kInvalidIndex, "A pass can only have a single output");
+  pass.write = resource.index;
+}
+
+void RenderGraph::PassBuilder::SetClear(const RenderPassClear &clear) {
+  graph_.passes_[pass_index_].clear = clear;
+}
+
+void RenderGraph::PassBuilder::SetHasSideEffects() {
+  graph_.passes_[pass_index_].has_side_effects = true;
+}
+
+RenderGraph::~RenderGraph() {
+  for (const bgfx::ViewId view_id : reserved_views_) {
+    FreeViewId(view_id);
+  }
+}
+
+RenderGraphResource RenderGraph::ImportWindow(const Window &window) {
+  const auto it = std::ranges::find_if(resources_, [&window](const Resource &resource) {
+    return resource.is_window && resource.window_view == window.GetView();
+  });
+  if (it != resources_.end()) {
+    return RenderGraphResource{gsl::narrow_cast<std::uint32_t>(std::distance(resources_.begin(), it))};
+  }
+
+  Resource &resource = resources_.emplace_back();
+  resource.name = "Window";
+  resource.descriptor.size = window.GetBackBufferSize();
+  resource.is_window = true;
+  resource.is_presentable = window.GetIsRenderable();
+  resource.window_view = window.GetView();
+  resource.window_frame_buffer = window.GetFrameBuffer();
+  return RenderGraphResource{gsl::narrow_cast<std::uint32_t>(resources_.size() - 1)};
+}
+
+void RenderGraph::AddPass(std::string name, const SetupFunction &setup, ExecuteFunction execute) {
+  Pass &pass = passes_.emplace_back();
+  pass.name = std::move(name);
+  pass.execute = std::move(execute);
+  PassBuilder builder(*this, gsl::narrow_cast<std::uint32_t>(passes_.size() - 1));
+  setup(builder);
+}
+
+std::size_t RenderGraph::Execute() {
+  const std::uint32_t frame = GetSubmittedFrameCount();
+  big2::Validate(executed_frame != frame, "Only one render graph can be executed per frame, frames have to be submitted with big2::Frame()");
+  executed_frame = frame;
+
+  CullPasses();
+  const std::vector<PassView> views = AssignViews();
+  OrderViews(views);
+
+  std::size_t executed_count = 0;
+  for (std::uint32_t pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+    Pass &pass = passes_[pass_index];
+    if (!pass.is_alive) {
+      continue;
+    }
+
+    for (const std::uint32_t resource_index : pass.reads) {
+      Resource &resource = resources_[resource_index];
+      if (!resource.target.IsValid()) {
+        big2::Warning(spdlog::fmt_lib::format("Pass {} reads {} before anything writes to it", pass.name, resource.name).c_str());
+        resource.target = GetPool().Acquire(resource.descriptor);
+      }
+    }
+
+    const PassView &view = views[pass_index];
+    glm::u16vec2 size = {0, 0};
+    if (pass.write != RenderGraphResource::kInvalidIndex) {
+      Resource &output = resources_[pass.write];
+      size = output.descriptor.size;
+      if (output.is_window) {
+        bgfx::setViewFrameBuffer(view.view_id, output.window_frame_buffer);
+      } else {
+        if (!output.target.IsValid()) {
+          output.target = GetPool().Acquire(output.descriptor);
+        }
+        bgfx::setViewFrameBuffer(view.view_id, output.target.frame_buffer);
+      }
+      bgfx::setViewRect(view.view_id, 0, 0, size.x, size.y);
+    }
+
+    if (pass.clear.has_value()) {
+      bgfx::setViewClear(view.view_id, pass.clear->flags, pass.clear->rgba, pass.clear->depth, pass.clear->stencil);
+    } else if (!view.is_window_view) {
+      bgfx::setViewClear(view.view_id, BGFX_CLEAR_NONE);
+    }
+
+    bgfx::setViewName(view.view_id, pass.name.c_str());
+    bgfx::touch(view.view_id);
+    pass.execute(RenderPassContext(*this, view.view_id, size));
+    executed_count++;
+
+    // The offscreen views are ordered like the passes, so a target can be handed out to the next pass once its last reader was set up
+    for (Resource &resource : resources_) {
+      if (resource.target.IsValid() && resource.last_use == pass_index && !resource.is_read_by_window_pass) {
+        GetPool().Release(resource.target);
+        resource.target = {};
+      }
+    }
+  }
+
+  for (Resource &resource : resources_) {
+    if (resource.target.IsValid()) {
+      GetPool().Release(resource.target);
+    }
+  }
+
+  passes_.clear();
+  resources_.clear();
+  return executed_count;
+}
+
+void RenderGraph::CullPasses() {
+  // Resources can only be read after they were written in the same frame, so a single backwards walk finds every contributing pass
+  std::vector<bool> is_needed(resources_.size(), false);
+  for (auto pass = passes_.rbegin(); pass != passes_.rend(); ++pass) {
+    const bool has_output = pass->write != RenderGraphResource::kInvalidIndex;
+    pass->is_alive = pass->has_side_effects || (has_output && (resources_[pass->write].is_presentable || is_needed[pass->write]));
+    if (!pass->is_alive) {
+      continue;
+    }
+
+    for (const std::uint32_t resource_index : pass->reads) {
+      is_needed[resource_index] = true;
+    }
+  }
+
+  for (std::uint32_t pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+    const Pass &pass = passes_[pass_index];
+    if (!pass.is_alive) {
+      continue;
+    }
+
+    const bool writes_window = pass.write != RenderGraphResource::kInvalidIndex && resources_[pass.write].is_window;
+    for (const std::uint32_t resource_index : pass.reads) {
+      resources_[resource_index].last_use = pass_index;
+      resources_[resource_index].is_read_by_window_pass |= writes_window;
+    }
+    if (pass.write != RenderGraphResource::kInvalidIndex) {
+      resources_[pass.write].last_use = pass_index;
+    }
+  }
+}
+
+std::vector<RenderGraph::PassView> RenderGraph::AssignViews() {
+  std::vector<PassView> views(passes_.size());
+  std::vector<bool> is_window_view_used(resources_.size(), false);
+  std::size_t reserved_view_index = 0;
+
+  for (std::uint32_t pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+    const Pass &pass = passes_[pass_index];
+    if (!pass.is_alive) {
+      continue;
+    }
+
+    PassView &view = views[pass_index];
+    const bool writes_window = pass.write != RenderGraphResource::kInvalidIndex && resources_[pass.write].is_window;
+    if (writes_window && !is_window_view_used[pass.write]) {
+      is_window_view_used[pass.write] = true;
+      view.view_id = resources_[pass.write].window_view;
+      view.is_window_view = true;
+      continue;
+    }
+
+    view.view_id = GetReservedView(reserved_view_index++);
+    if (writes_window) {
+      view.window_view = resources_[pass.write].window_view;
+    }
+  }
+
+  return views;
+}
+
+void RenderGraph::OrderViews(const std::vector<PassView> &views) {
+  const std::uint32_t max_views = bgfx::getCaps()->limits.maxViews;
+
+  std::vector<bool> is_placed(max_views, false);
+  std::map<bgfx::ViewId, std::vector<bgfx::ViewId>> window_view_followers;
+  std::vector<bgfx::ViewId> order;
+  order.reserve(max_views);
+
+  // Offscreen passes go before every window so their outputs are ready when the windows are drawn
+  for (std::size_t pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+    const PassView &view = views[pass_index];
+    if (!passes_[pass_index].is_alive || view.is_window_view) {
+      continue;
+    }
+
+    is_placed[view.view_id] = true;
+    const bool writes_window = passes_[pass_index].write != RenderGraphResource::kInvalidIndex && resources_[passes_[pass_index].write].is_window;
+    if (writes_window) {
+      window_view_followers[view.window_view].push_back(view.view_id);
+    } else {
+      order.push_back(view.view_id);
+    }
+  }
+
+  // The rest keep their ascending order with extra window passes right after their window's view
+  for (std::uint32_t view_id = 0; view_id < max_views; ++view_id) {
+    if (is_placed[view_id]) {
+      continue;
+    }
+
+    order.push_back(gsl::narrow_cast<bgfx::ViewId>(view_id));
+    const auto followers = window_view_followers.find(gsl::narrow_cast<bgfx::ViewId>(view_id));
+    if (followers != window_view_followers.end()) {
+      order.insert(order.end(), followers->second.begin(), followers->second.end());
+    }
+  }
+
+  bgfx::setViewOrder(0, gsl::narrow_cast<std::uint16_t>(order.size()), order.data());
+}
+
+bgfx::ViewId RenderGraph::GetReservedView(std::size_t index) {
+  while (reserved_views_.size() <= index) {
+    reserved_views_.push_back(ReserveViewId());
+  }
+  return reserved_views_[index];
+}
+
+BgfxRenderTargetPool &RenderGraph::GetPool() const {
+  return pool_ != nullptr ? *pool_ : GetRenderTargetPool();
+}
+
+}
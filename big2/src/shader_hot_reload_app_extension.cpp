@@ -0,0 +1,34 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/shader_hot_reload_app_extension.h>
+
+namespace big2 {
+
+void ShaderHotReloadAppExtension::OnInitialize() {
+  AppExtensionBase::OnInitialize();
+  reloader_ = std::make_unique<ShaderHotReloader>();
+
+  if (const std::filesystem::path big2_shaders = GetBig2ShadersDirectory(); !big2_shaders.empty()) {
+    reloader_->WatchDirectory(big2_shaders);
+  }
+
+  for (const std::filesystem::path &directory : directories_) {
+    reloader_->WatchDirectory(directory);
+  }
+}
+
+void ShaderHotReloadAppExtension::OnTerminate() {
+  AppExtensionBase::OnTerminate();
+  reloader_.reset();
+}
+
+void ShaderHotReloadAppExtension::OnFrameBegin() {
+  AppExtensionBase::OnFrameBegin();
+  if (reloader_ != nullptr) {
+    reloader_->ApplyCompiledShaders();
+  }
+}
+
+}
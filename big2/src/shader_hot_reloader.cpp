@@ -0,0 +1,388 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/shader_hot_reloader.h>
+#include <big2/asserts.h>
+#include <big2/hash.h>
+#include <big2/thread_configuration.h>
+#include <big2/bgfx/bgfx_program_registry.h>
+#include <bx/bx.h>
+#include <spdlog/spdlog.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#if BX_PLATFORM_LINUX
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#if BX_PLATFORM_WINDOWS
+#define BIG2_POPEN _popen
+#define BIG2_PCLOSE _pclose
+#else
+#define BIG2_POPEN popen
+#define BIG2_PCLOSE pclose
+#endif
+
+namespace big2 {
+
+static constexpr std::chrono::milliseconds kWatchInterval{250};
+// Editors usually write a file in several steps, changes that come right after each other are compiled once
+static constexpr std::chrono::milliseconds kSettleTime{50};
+
+static bool IsShaderSource(const std::filesystem::path &path) {
+  const std::string file_name = path.filename().string();
+  if (!file_name.ends_with(".sc") || file_name.ends_with(".def.sc")) {
+    return false;
+  }
+  return file_name.starts_with("vs_") || file_name.starts_with("fs_") || file_name.ends_with(".vert.sc") || file_name.ends_with(".frag.sc");
+}
+
+static bool IsVertexShaderSource(const std::filesystem::path &path) {
+  const std::string file_name = path.filename().string();
+  return file_name.starts_with("vs_") || file_name.ends_with(".vert.sc");
+}
+
+static bool IsShaderDependency(const std::filesystem::path &path) {
+  const std::filesystem::path extension = path.extension();
+  return extension == ".sc" || extension == ".sh";
+}
+
+/**
+ * @brief The name the shader is embedded with, that is the file name up to the first dot.
+ */
+static std::string GetShaderName(const std::filesystem::path &path) {
+  const std::string file_name = path.filename().string();
+  return file_name.substr(0, file_name.find('.'));
+}
+
+static gsl::czstring GetHostPlatform() {
+#if BX_PLATFORM_WINDOWS
+  return "windows";
+#elif BX_PLATFORM_OSX
+  return "osx";
+#else
+  return "linux";
+#endif
+}
+
+#if BX_PLATFORM_LINUX
+class DirectoryWatcher final {
+ public:
+  DirectoryWatcher() : file_descriptor_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {
+    big2::SoftValidate(file_descriptor_ >= 0, "inotify couldn't be initialized, shader sources won't be watched");
+  }
+  DirectoryWatcher(const DirectoryWatcher &) = delete;
+  DirectoryWatcher &operator=(const DirectoryWatcher &) = delete;
+
+  ~DirectoryWatcher() {
+    if (file_descriptor_ >= 0) {
+      close(file_descriptor_);
+    }
+  }
+
+  void Add(const std::filesystem::path &directory) {
+    if (file_descriptor_ < 0) {
+      return;
+    }
+
+    const int watch_descriptor = inotify_add_watch(file_descriptor_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (big2::SoftValidate(watch_descriptor >= 0, spdlog::fmt_lib::format("Couldn't watch {}", directory.string()).c_str())) {
+      directories_[watch_descriptor] = directory;
+    }
+  }
+
+  std::vector<std::filesystem::path> Wait(std::chrono::milliseconds timeout) {
+    if (file_descriptor_ < 0) {
+      std::this_thread::sleep_for(timeout);
+      return {};
+    }
+
+    pollfd poll_descriptor{.fd = file_descriptor_, .events = POLLIN, .revents = 0};
+    if (poll(&poll_descriptor, 1, static_cast<int>(timeout.count())) <= 0) {
+      return {};
+    }
+
+    std::vector<std::filesystem::path> changes;
+    alignas(inotify_event) std::array<char, 4096> buffer{};
+    ssize_t length = 0;
+    while ((length = read(file_descriptor_, buffer.data(), buffer.size())) > 0) {
+      for (ssize_t offset = 0; offset < length;) {
+        const auto *event = reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+        auto directory = directories_.find(event->wd);
+        if (event->len > 0 && directory != directories_.end()) {
+          changes.push_back(directory->second / event->name);
+        }
+        offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+      }
+    }
+
+    return changes;
+  }
+
+ private:
+  int file_descriptor_;
+  std::unordered_map<int, std::filesystem::path> directories_;
+};
+#else
+class DirectoryWatcher final {
+ public:
+  void Add(const std::filesystem::path &directory) {
+    directories_.push_back(directory);
+    Scan(directory, nullptr);
+  }
+
+  std::vector<std::filesystem::path> Wait(std::chrono::milliseconds timeout) {
+    std::this_thread::sleep_for(timeout);
+
+    std::vector<std::filesystem::path> changes;
+    for (const std::filesystem::path &directory : directories_) {
+      Scan(directory, &changes);
+    }
+    return changes;
+  }
+
+ private:
+  void Scan(const std::filesystem::path &directory, std::vector<std::filesystem::path> *changes) {
+    std::error_code error;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory, error)) {
+      if (!IsShaderDependency(entry.path())) {
+        continue;
+      }
+
+      const std::filesystem::file_time_type write_time = entry.last_write_time(error);
+      auto [it, is_inserted] = write_times_.try_emplace(entry.path(), write_time);
+      if (!is_inserted && it->second != write_time) {
+        it->second = write_time;
+        if (changes != nullptr) {
+          changes->push_back(entry.path());
+        }
+      }
+    }
+  }
+
+  std::vector<std::filesystem::path> directories_;
+  std::map<std::filesystem::path, std::filesystem::file_time_type> write_times_;
+};
+#endif
+
+ShaderCompilerSettings GetDefaultShaderCompilerSettings() {
+#if defined(BIG2_SHADERC_PATH) && defined(BIG2_BGFX_SHADER_INCLUDE_DIR)
+  return ShaderCompilerSettings{.shaderc_path = BIG2_SHADERC_PATH, .include_directories = {BIG2_BGFX_SHADER_INCLUDE_DIR}};
+#else
+  return {};
+#endif
+}
+
+std::filesystem::path GetBig2ShadersDirectory() {
+#if defined(BIG2_SHADERS_SOURCE_DIR)
+  return BIG2_SHADERS_SOURCE_DIR;
+#else
+  return {};
+#endif
+}
+
+ShaderHotReloader::ShaderHotReloader(ShaderCompilerSettings settings) : settings_(std::move(settings)) {
+  big2::SoftValidate(!settings_.shaderc_path.empty(), "No shaderc was given, build BIG2 with BIG2_SHADER_HOT_RELOAD or set the path yourself");
+
+  platform_ = GetHostPlatform();
+  switch (bgfx::getRendererType()) {
+    case bgfx::RendererType::Direct3D11:
+    case bgfx::RendererType::Direct3D12:
+      platform_ = "windows";
+      profile_ = "s_5_0";
+      break;
+    case bgfx::RendererType::Metal:
+      platform_ = "osx";
+      profile_ = "metal";
+      break;
+    case bgfx::RendererType::OpenGLES:
+      platform_ = "android";
+      profile_ = "100_es";
+      break;
+    case bgfx::RendererType::Vulkan:
+      profile_ = "spirv";
+      break;
+    default:
+      profile_ = "120";
+      break;
+  }
+
+  worker_ = std::jthread([this](const std::stop_token &stop_token) { Run(stop_token); });
+
+  if (!settings_.shaderc_path.empty()) {
+    SetShaderVariantCompiler([this](ShaderVariantRequest request) {
+      std::scoped_lock lock(mutex_);
+      new_variant_requests_.push_back(std::move(request));
+    });
+  }
+}
+
+ShaderHotReloader::~ShaderHotReloader() {
+  SetShaderVariantCompiler(nullptr);
+  worker_.request_stop();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void ShaderHotReloader::WatchDirectory(std::filesystem::path directory) {
+  std::scoped_lock lock(mutex_);
+  new_directories_.push_back(std::move(directory));
+}
+
+std::size_t ShaderHotReloader::ApplyCompiledShaders() {
+  std::vector<CompiledShader> compiled_shaders;
+  {
+    std::scoped_lock lock(mutex_);
+    compiled_shaders.swap(compiled_shaders_);
+  }
+
+  std::size_t replaced_count = 0;
+  for (CompiledShader &shader : compiled_shaders) {
+    if (!shader.errors.empty()) {
+      big2::Error(spdlog::fmt_lib::format("Shader {} couldn't be compiled:\n{}", shader.name, shader.errors).c_str());
+      continue;
+    }
+
+    const std::size_t programs_count = ReplaceShaderBinary(HashedName(HashName(shader.name)), std::move(shader.binary));
+    big2::Info(spdlog::fmt_lib::format("Reloaded shader {} used by {} programs", shader.name, programs_count).c_str());
+    replaced_count++;
+  }
+
+  return replaced_count;
+}
+
+void ShaderHotReloader::Run(const std::stop_token &stop_token) {
+  ApplyThreadConfiguration(ThreadRole::Worker);
+  DirectoryWatcher watcher;
+  // The variants compiled so far, they are compiled again when their source changes
+  std::map<std::filesystem::path, std::vector<ShaderVariantRequest>> variants;
+
+  while (!stop_token.stop_requested()) {
+    std::vector<ShaderVariantRequest> requests;
+    {
+      std::scoped_lock lock(mutex_);
+      for (const std::filesystem::path &directory : new_directories_) {
+        watcher.Add(directory);
+      }
+      new_directories_.clear();
+      requests.swap(new_variant_requests_);
+    }
+
+    for (const ShaderVariantRequest &request : requests) {
+      variants[request.source.lexically_normal()].push_back(request);
+    }
+
+    std::vector<std::filesystem::path> changes = watcher.Wait(kWatchInterval);
+    if (!changes.empty()) {
+      std::vector<std::filesystem::path> late_changes = watcher.Wait(kSettleTime);
+      changes.insert(changes.end(), late_changes.begin(), late_changes.end());
+    }
+
+    // Includes and the varying definitions can be used by any shader of their directory
+    std::set<std::filesystem::path> sources;
+    for (const std::filesystem::path &change : changes) {
+      if (IsShaderSource(change)) {
+        sources.insert(change.lexically_normal());
+      } else if (IsShaderDependency(change)) {
+        std::error_code error;
+        for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(change.parent_path(), error)) {
+          if (IsShaderSource(entry.path())) {
+            sources.insert(entry.path().lexically_normal());
+          }
+        }
+      }
+    }
+
+    for (const std::filesystem::path &source : sources) {
+      ShaderVariantRequest &request = requests.emplace_back();
+      request.name = GetShaderName(source);
+      request.variant = HashedName(HashName(request.name));
+      request.source = source;
+
+      if (auto source_variants = variants.find(source); source_variants != variants.end()) {
+        requests.insert(requests.end(), source_variants->second.begin(), source_variants->second.end());
+      }
+    }
+
+    for (const ShaderVariantRequest &request : requests) {
+      if (stop_token.stop_requested()) {
+        break;
+      }
+
+      CompiledShader compiled_shader = Compile(request);
+      std::scoped_lock lock(mutex_);
+      compiled_shaders_.push_back(std::move(compiled_shader));
+    }
+  }
+}
+
+ShaderHotReloader::CompiledShader ShaderHotReloader::Compile(const ShaderVariantRequest &request) const {
+  const std::filesystem::path &source = request.source;
+  CompiledShader result{.name = request.name, .source = source, .binary = {}, .errors = {}};
+
+  const std::filesystem::path output_path = std::filesystem::temp_directory_path() / spdlog::fmt_lib::format("big2_{}.bin", request.name);
+  std::string command = spdlog::fmt_lib::format(R"("{}" -f "{}" -o "{}" --type {} --platform {} -p {} --varyingdef "{}" -i "{}")",
+                                                settings_.shaderc_path.string(),
+                                                source.string(),
+                                                output_path.string(),
+                                                IsVertexShaderSource(source) ? "vertex" : "fragment",
+                                                platform_,
+                                                profile_,
+                                                (source.parent_path() / "varying.def.sc").string(),
+                                                source.parent_path().string());
+  for (const std::filesystem::path &include_directory : settings_.include_directories) {
+    command += spdlog::fmt_lib::format(R"( -i "{}")", include_directory.string());
+  }
+  if (!request.defines.empty()) {
+    std::string defines;
+    for (const std::string &define : request.defines) {
+      defines += defines.empty() ? define : ";" + define;
+    }
+    command += spdlog::fmt_lib::format(R"( --define "{}")", defines);
+  }
+  command += " 2>&1";
+#if BX_PLATFORM_WINDOWS
+  // cmd.exe strips the first and last quote of the whole command
+  command = "\"" + command + "\"";
+#endif
+
+  FILE *pipe = BIG2_POPEN(command.c_str(), "r");
+  if (pipe == nullptr) {
+    result.errors = "shaderc couldn't be started";
+    return result;
+  }
+
+  std::string output;
+  std::array<char, 256> line{};
+  while (std::fgets(line.data(), static_cast<int>(line.size()), pipe) != nullptr) {
+    output += line.data();
+  }
+
+  if (BIG2_PCLOSE(pipe) != 0) {
+    result.errors = output.empty() ? "shaderc failed without output" : std::move(output);
+    return result;
+  }
+
+  std::ifstream file(output_path, std::ios::binary);
+  result.binary.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  file.close();
+
+  std::error_code error;
+  std::filesystem::remove(output_path, error);
+
+  if (result.binary.empty()) {
+    result.errors = "shaderc didn't write a binary";
+  }
+  return result;
+}
+
+}
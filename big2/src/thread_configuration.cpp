@@ -0,0 +1,217 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/thread_configuration.h>
+#include <big2/asserts.h>
+#include <bx/bx.h>
+#include <spdlog/spdlog.h>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#if BX_PLATFORM_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace big2 {
+
+struct RegisteredThread {
+  ThreadRole role;
+  std::string name;
+  std::int64_t native_id;
+};
+
+static std::mutex registry_mutex;
+static std::array<std::optional<ThreadConfiguration>, 3> role_configurations;
+static std::vector<RegisteredThread> registered_threads;
+
+#if BX_PLATFORM_LINUX
+
+static void RegisterThread(ThreadRole role, std::string name, std::int64_t native_id) {
+  std::scoped_lock lock(registry_mutex);
+  std::erase_if(registered_threads, [native_id](const RegisteredThread &thread) { return thread.native_id == native_id; });
+  registered_threads.push_back({.role = role, .name = std::move(name), .native_id = native_id});
+}
+
+static std::int64_t GetCurrentThreadNativeId() {
+  return static_cast<std::int64_t>(syscall(SYS_gettid));
+}
+
+static std::filesystem::path GetThreadProcPath(std::int64_t native_id) {
+  return std::filesystem::path("/proc/self/task") / std::to_string(native_id);
+}
+
+static std::string ReadThreadName(std::int64_t native_id) {
+  std::ifstream comm_file(GetThreadProcPath(native_id) / "comm");
+  std::string name;
+  std::getline(comm_file, name);
+  return name;
+}
+
+static bool SetThreadName(std::int64_t native_id, const std::string &name) {
+  // The kernel limit is 16 bytes including the terminating zero
+  const std::string truncated_name = name.substr(0, 15);
+  if (native_id == GetCurrentThreadNativeId()) {
+    return pthread_setname_np(pthread_self(), truncated_name.c_str()) == 0;
+  }
+
+  std::ofstream comm_file(GetThreadProcPath(native_id) / "comm");
+  comm_file << truncated_name;
+  return comm_file.good();
+}
+
+static bool SetThreadAffinity(std::int64_t native_id, const std::vector<std::uint32_t> &cpus) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (std::uint32_t cpu : cpus) {
+    CPU_SET(cpu, &cpu_set);
+  }
+
+  if (native_id == GetCurrentThreadNativeId()) {
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+  }
+
+  return sched_setaffinity(static_cast<pid_t>(native_id), sizeof(cpu_set), &cpu_set) == 0;
+}
+
+static bool SetThreadScheduling(std::int64_t native_id, ThreadSchedulingPolicy policy, std::int32_t priority) {
+  const pid_t tid = static_cast<pid_t>(native_id);
+  sched_param parameters{};
+
+  switch (policy) {
+    case ThreadSchedulingPolicy::Default:
+      return sched_setscheduler(tid, SCHED_OTHER, &parameters) == 0 && setpriority(PRIO_PROCESS, tid, priority) == 0;
+    case ThreadSchedulingPolicy::Batch:
+      return sched_setscheduler(tid, SCHED_BATCH, &parameters) == 0 && setpriority(PRIO_PROCESS, tid, priority) == 0;
+    case ThreadSchedulingPolicy::Idle:
+      return sched_setscheduler(tid, SCHED_IDLE, &parameters) == 0;
+    case ThreadSchedulingPolicy::Fifo:
+      parameters.sched_priority = priority;
+      return sched_setscheduler(tid, SCHED_FIFO, &parameters) == 0;
+    case ThreadSchedulingPolicy::RoundRobin:
+      parameters.sched_priority = priority;
+      return sched_setscheduler(tid, SCHED_RR, &parameters) == 0;
+  }
+
+  return false;
+}
+
+static bool ConfigureThread(ThreadRole role, std::int64_t native_id, const std::optional<ThreadConfiguration> &configuration) {
+  bool is_successful = true;
+
+  if (configuration.has_value()) {
+    if (!configuration->name.empty() && !SetThreadName(native_id, configuration->name)) {
+      big2::Warning(spdlog::fmt_lib::format("Couldn't set the name of thread {}", native_id).c_str());
+      is_successful = false;
+    }
+
+    if (!configuration->cpu_affinity.empty() && !SetThreadAffinity(native_id, configuration->cpu_affinity)) {
+      big2::Warning(spdlog::fmt_lib::format("Couldn't set the CPU affinity of thread {}", native_id).c_str());
+      is_successful = false;
+    }
+
+    const bool has_scheduling = configuration->policy != ThreadSchedulingPolicy::Default || configuration->priority != 0;
+    if (has_scheduling && !SetThreadScheduling(native_id, configuration->policy, configuration->priority)) {
+      big2::Warning(spdlog::fmt_lib::format("Couldn't set the scheduling policy of thread {} (missing privileges?)", native_id).c_str());
+      is_successful = false;
+    }
+  }
+
+  RegisterThread(role, ReadThreadName(native_id), native_id);
+  return is_successful;
+}
+
+static std::optional<std::chrono::nanoseconds> ReadThreadCpuTime(std::int64_t native_id) {
+  // schedstat has nanosecond precision but depends on the kernel configuration so stat is the fallback
+  std::ifstream schedstat_file(GetThreadProcPath(native_id) / "schedstat");
+  std::int64_t run_time_ns = 0;
+  if (schedstat_file >> run_time_ns) {
+    return std::chrono::nanoseconds(run_time_ns);
+  }
+
+  std::ifstream stat_file(GetThreadProcPath(native_id) / "stat");
+  std::string stat;
+  if (!std::getline(stat_file, stat)) {
+    return {};
+  }
+
+  // The name could contain spaces so fields are counted after its closing parenthesis
+  std::istringstream fields(stat.substr(stat.rfind(')') + 1));
+  std::string field;
+  std::int64_t user_ticks = 0;
+  std::int64_t system_ticks = 0;
+  for (std::int32_t i = 0; i < 11; i++) {
+    fields >> field;
+  }
+  fields >> user_ticks >> system_ticks;
+
+  const std::int64_t ticks_per_second = sysconf(_SC_CLK_TCK);
+  return std::chrono::nanoseconds((user_ticks + system_ticks) * 1'000'000'000 / ticks_per_second);
+}
+
+#endif // BX_PLATFORM_LINUX
+
+void SetThreadConfiguration(ThreadRole role, ThreadConfiguration configuration) {
+  std::scoped_lock lock(registry_mutex);
+  role_configurations.at(static_cast<std::size_t>(role)) = std::move(configuration);
+}
+
+std::optional<ThreadConfiguration> GetThreadConfiguration(ThreadRole role) {
+  std::scoped_lock lock(registry_mutex);
+  return role_configurations.at(static_cast<std::size_t>(role));
+}
+
+bool ApplyThreadConfiguration(ThreadRole role) {
+#if BX_PLATFORM_LINUX
+  return ConfigureThread(role, GetCurrentThreadNativeId(), GetThreadConfiguration(role));
+#else
+  if (GetThreadConfiguration(role).has_value()) {
+    big2::Warning("Thread configuration is only supported on Linux");
+  }
+  return false;
+#endif
+}
+
+bool ApplyRenderThreadConfiguration() {
+#if BX_PLATFORM_LINUX
+  // BGFX doesn't expose its render thread so it is found by the name it gives to it
+  for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator("/proc/self/task")) {
+    const std::int64_t native_id = std::stoll(entry.path().filename().string());
+    if (ReadThreadName(native_id).starts_with("bgfx")) {
+      return ConfigureThread(ThreadRole::Render, native_id, GetThreadConfiguration(ThreadRole::Render));
+    }
+  }
+
+  return true;
+#else
+  if (GetThreadConfiguration(ThreadRole::Render).has_value()) {
+    big2::Warning("Thread configuration is only supported on Linux");
+  }
+  return false;
+#endif
+}
+
+std::vector<ThreadCpuTime> GetThreadCpuTimes() {
+  std::vector<ThreadCpuTime> result;
+
+#if BX_PLATFORM_LINUX
+  std::scoped_lock lock(registry_mutex);
+  for (const RegisteredThread &thread : registered_threads) {
+    std::optional<std::chrono::nanoseconds> cpu_time = ReadThreadCpuTime(thread.native_id);
+    if (cpu_time.has_value()) {
+      result.push_back({.role = thread.role, .name = thread.name, .cpu_time = cpu_time.value()});
+    }
+  }
+#endif
+
+  return result;
+}
+
+}
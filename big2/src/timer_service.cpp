@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2024 Paper Cranes Ltd.
+// All rights reserved.
+//
+#include <big2/timer_service.h>
+#include <algorithm>
+
+namespace big2 {
+
+// std heap functions build a max-heap so the comparison is reversed to keep the earliest deadline on top
+constexpr auto kIsLaterDeadline = [](const auto &left, const auto &right) {
+  return left.time > right.time;
+};
+
+TimerService::TimerId TimerService::AddTimeout(duration delay, std::function<void()> callback) {
+  return AddTimer(delay, duration::zero(), false, std::move(callback));
+}
+
+TimerService::TimerId TimerService::AddInterval(duration period, std::function<void()> callback) {
+  return AddTimer(period, period, true, std::move(callback));
+}
+
+bool TimerService::Cancel(TimerId id) {
+  // The deadline stays in the heap and is dropped when it reaches the top
+  return timers_.erase(id) > 0;
+}
+
+std::size_t TimerService::Dispatch(time_point now) {
+  std::vector<Deadline> rescheduled;
+  std::size_t called_count = 0;
+
+  while (!deadlines_.empty() && deadlines_.front().time <= now) {
+    const Deadline deadline = deadlines_.front();
+    PopDeadline();
+
+    auto it = timers_.find(deadline.id);
+    if (it == timers_.end()) {
+      continue;
+    }
+
+    // The callback is taken out since it could add timers and invalidate the iterator
+    std::function<void()> callback = std::move(it->second.callback);
+    if (it->second.is_repeating) {
+      const time_point next_time = std::max(deadline.time + it->second.period, now);
+      rescheduled.push_back({.time = next_time, .id = deadline.id});
+    } else {
+      timers_.erase(it);
+    }
+
+    callback();
+    called_count++;
+
+    it = timers_.find(deadline.id);
+    if (it != timers_.end()) {
+      it->second.callback = std::move(callback);
+    }
+  }
+
+  // Pushed after the loop so that zero-period intervals are called at most once per dispatch
+  for (const Deadline &deadline : rescheduled) {
+    if (timers_.contains(deadline.id)) {
+      PushDeadline(deadline);
+    }
+  }
+
+  return called_count;
+}
+
+std::optional<TimerService::time_point> TimerService::GetNextDeadline() {
+  DropCancelledDeadlines();
+  if (deadlines_.empty()) {
+    return {};
+  }
+
+  return deadlines_.front().time;
+}
+
+TimerService::TimerId TimerService::AddTimer(duration delay, duration period, bool is_repeating, std::function<void()> callback) {
+  const TimerId id = next_id_++;
+  timers_.emplace(id, Timer{.callback = std::move(callback), .period = period, .is_repeating = is_repeating});
+  PushDeadline({.time = clock::now() + delay, .id = id});
+  return id;
+}
+
+void TimerService::PushDeadline(Deadline deadline) {
+  deadlines_.push_back(deadline);
+  std::push_heap(deadlines_.begin(), deadlines_.end(), kIsLaterDeadline);
+}
+
+void TimerService::PopDeadline() {
+  std::pop_heap(deadlines_.begin(), deadlines_.end(), kIsLaterDeadline);
+  deadlines_.pop_back();
+}
+
+void TimerService::DropCancelledDeadlines() {
+  while (!deadlines_.empty() && !timers_.contains(deadlines_.front().id)) {
+    PopDeadline();
+  }
+}
+
+}
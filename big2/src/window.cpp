@@ -6,6 +6,8 @@
 #include <big2/asserts.h>
 #include <GLFW/glfw3.h>
 #include <big2/bgfx/bgfx_utils.h>
+#include <big2/bgfx/bgfx_destruction_queue.h>
+#include <big2/bgfx/bgfx_resource_tracker.h>
 #include <big2/glfw/glfw_utils.h>
 #include <big2/event_queue.h>
 
@@ -43,15 +45,22 @@ Window & Window::SetIsResizable(bool is_resizable) {
 }
 
 void Window::Dispose() {
-  glfwDestroyWindow(window_);
+  if (!BgfxSupportsMultipleWindows()) {
+    BgfxInitializationScoped::GetInstance()->UnbindWindow(window_);
+  }
+
   bgfx::resetView(view_id_);
+  ReleaseFrameBuffer();
 
-  if(isValid(frame_buffer_)) {
-    bgfx::destroy(frame_buffer_);
-    frame_buffer_ = BGFX_INVALID_HANDLE;
-  }
+  // The view id isn't given to another window until the frames that were submitted to it are done
+  ExecuteOnFrameFence(InsertFrameFence(), [view_id = view_id_]() { FreeViewId(view_id); });
 
-  FreeViewId(view_id_);
+  // The frame buffer is destroyed by the queue once its frames are done and BGFX destroys the swap chain on the
+  // frame after that, the native window has to outlive it
+  glfwHideWindow(window_);
+  ExecuteOnFrameFence(InsertFrameFence(), [window = window_]() {
+    ExecuteOnFrameFence(InsertFrameFence(), [window]() { glfwDestroyWindow(window); });
+  });
 
   view_id_ = BGFX_INVALID_HANDLE;
 }
@@ -59,18 +68,51 @@ void Window::Dispose() {
 void Window::Initialize() {
   const glm::u16vec2 initial_window_resolution = GetResolution();
   view_id_ = ReserveViewId();
+  back_buffer_size_ = initial_window_resolution;
 
-  if (BgfxSupportsMultipleWindows()) {
-    bgfx::createFrameBuffer(GetNativeWindowHandle(window_), initial_window_resolution.x, initial_window_resolution.y, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::D24S8);
-    frame_buffer_ = bgfx::createFrameBuffer(GetNativeWindowHandle(window_), initial_window_resolution.x, initial_window_resolution.y);
-    bgfx::setViewFrameBuffer(view_id_, frame_buffer_);
-  } else {
-    BgfxInitializationScoped::GetInstance()->ReInitialize(window_, initial_window_resolution);
+  if (!BgfxSupportsMultipleWindows()) {
+    BgfxInitializationScoped::GetInstance()->BindWindow(window_, initial_window_resolution);
   }
 
   bgfx::setViewRect(view_id_, 0, 0, initial_window_resolution.x, initial_window_resolution.y);
   bgfx::setViewClear(view_id_, BGFX_CLEAR_COLOR, 0x000000FF);
-  back_buffer_size_ = initial_window_resolution;
+  UpdateFrameBuffer();
+}
+
+void Window::UpdateFrameBuffer(clock::duration release_delay) {
+  if (!BgfxSupportsMultipleWindows()) {
+    return;
+  }
+
+  if (GetIsVisible()) {
+    hidden_since_.reset();
+    if (!isValid(frame_buffer_)) {
+      CreateFrameBuffer();
+    }
+    return;
+  }
+
+  const clock::time_point now = clock::now();
+  if (!hidden_since_.has_value()) {
+    hidden_since_ = now;
+  }
+
+  if (isValid(frame_buffer_) && now - hidden_since_.value() >= release_delay) {
+    ReleaseFrameBuffer();
+  }
+}
+
+void Window::CreateFrameBuffer() {
+  frame_buffer_ = TrackResource(bgfx::createFrameBuffer(GetNativeWindowHandle(window_), back_buffer_size_.x, back_buffer_size_.y),
+                                EstimateWindowFrameBufferBytes(back_buffer_size_));
+  bgfx::setViewFrameBuffer(view_id_, frame_buffer_);
+}
+
+void Window::ReleaseFrameBuffer() {
+  if (isValid(frame_buffer_)) {
+    big2::DestroyDeferred(frame_buffer_);
+    frame_buffer_ = BGFX_INVALID_HANDLE;
+  }
 }
 
 void Window::SetClearColor(std::uint32_t rgba) const {
@@ -86,12 +128,20 @@ glm::u16vec2 Window::GetResolution() const {
 }
 
 void Window::SetFrameSize(glm::u16vec2 size) {
+  // Iconified windows report a zero size, their frame buffer is kept until UpdateFrameBuffer() releases it
+  if (size.x == 0 || size.y == 0) {
+    return;
+  }
+
   back_buffer_size_ = size;
   if (BgfxSupportsMultipleWindows()) {
-    bgfx::destroy(frame_buffer_);
-    frame_buffer_ = bgfx::createFrameBuffer(GetNativeWindowHandle(window_), size.x, size.y);
-    bgfx::setViewFrameBuffer(view_id_, frame_buffer_);
-  } else {
+    // A released frame buffer is created with the new size once the window is visible again
+    if (isValid(frame_buffer_)) {
+      UntrackResource(frame_buffer_);
+      bgfx::destroy(frame_buffer_);
+      CreateFrameBuffer();
+    }
+  } else if (BgfxInitializationScoped::GetInstance()->GetBoundWindow() == window_) {
     bgfx::reset(size.x, size.y);
   }
 
@@ -109,4 +159,17 @@ bool Window::GetShouldClose() const {
 glm::u16vec2 Window::GetBackBufferSize() const {
   return back_buffer_size_;
 }
+
+bool Window::GetIsVisible() const {
+  const glm::u16vec2 size = GetSize();
+  return glfwGetWindowAttrib(window_, GLFW_VISIBLE) && !glfwGetWindowAttrib(window_, GLFW_ICONIFIED) && size.x > 0 && size.y > 0;
+}
+
+bool Window::GetIsRenderable() const {
+  if (!BgfxSupportsMultipleWindows()) {
+    // Only the bound window is presented, the others would draw into its back buffer
+    return GetIsVisible() && BgfxInitializationScoped::GetInstance()->GetBoundWindow() == window_;
+  }
+  return GetIsVisible() && isValid(frame_buffer_);
+}
 }
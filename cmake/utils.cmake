@@ -1,3 +1,78 @@
+# Reads <shader>.variants.json next to SHADER_FILE and writes a source for each precompiled variant into VARIANTS_DIR.
+# The file lists the define keys of the shader and the combinations that are embedded:
+# { "keys": ["VERTEX_COLOR", "TEXTURE"], "precompile": [["VERTEX_COLOR"], ["VERTEX_COLOR", "TEXTURE"]] }
+# Other combinations are compiled when the app uses them, see big2::GetShaderVariant().
+function(add_shader_variants SHADER_FILE VARIANTS_DIR WRAPPERS_OUT_VAR DECLARATION_OUT_VAR)
+    get_filename_component(SHADER_NAME "${SHADER_FILE}" NAME_WE)
+    get_filename_component(SHADER_DIR "${SHADER_FILE}" DIRECTORY)
+    set(VARIANTS_FILE "${SHADER_DIR}/${SHADER_NAME}.variants.json")
+
+    set("${WRAPPERS_OUT_VAR}" "" PARENT_SCOPE)
+    set("${DECLARATION_OUT_VAR}" "" PARENT_SCOPE)
+    if(NOT EXISTS "${VARIANTS_FILE}")
+        return()
+    endif()
+
+    # The variant sources are copies of the shader, shaderc only reads $input and $output from the file it compiles
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS "${VARIANTS_FILE}" "${SHADER_FILE}")
+    file(READ "${VARIANTS_FILE}" VARIANTS_JSON)
+    file(READ "${SHADER_FILE}" SHADER_SOURCE)
+
+    set(KEYS)
+    string(JSON KEY_COUNT LENGTH "${VARIANTS_JSON}" keys)
+    if(KEY_COUNT GREATER 32)
+        message(FATAL_ERROR "${VARIANTS_FILE} has more than 32 keys")
+    endif()
+    if(KEY_COUNT GREATER 0)
+        math(EXPR LAST_KEY_INDEX "${KEY_COUNT} - 1")
+        foreach(KEY_INDEX RANGE ${LAST_KEY_INDEX})
+            string(JSON KEY GET "${VARIANTS_JSON}" keys ${KEY_INDEX})
+            list(APPEND KEYS "${KEY}")
+        endforeach()
+    endif()
+
+    set(WRAPPERS)
+    string(JSON VARIANT_COUNT ERROR_VARIABLE NO_PRECOMPILED_VARIANTS LENGTH "${VARIANTS_JSON}" precompile)
+    if(NOT NO_PRECOMPILED_VARIANTS AND VARIANT_COUNT GREATER 0)
+        math(EXPR LAST_VARIANT_INDEX "${VARIANT_COUNT} - 1")
+        foreach(VARIANT_INDEX RANGE ${LAST_VARIANT_INDEX})
+            set(MASK 0)
+            set(DEFINES "")
+            string(JSON VARIANT_KEY_COUNT LENGTH "${VARIANTS_JSON}" precompile ${VARIANT_INDEX})
+            if(VARIANT_KEY_COUNT EQUAL 0)
+                continue()
+            endif()
+
+            math(EXPR LAST_VARIANT_KEY_INDEX "${VARIANT_KEY_COUNT} - 1")
+            foreach(VARIANT_KEY_INDEX RANGE ${LAST_VARIANT_KEY_INDEX})
+                string(JSON KEY GET "${VARIANTS_JSON}" precompile ${VARIANT_INDEX} ${VARIANT_KEY_INDEX})
+                list(FIND KEYS "${KEY}" KEY_BIT)
+                if(KEY_BIT EQUAL -1)
+                    message(FATAL_ERROR "${VARIANTS_FILE} precompiles the undeclared key ${KEY}")
+                endif()
+                math(EXPR MASK "${MASK} | (1 << ${KEY_BIT})")
+                string(APPEND DEFINES "#define ${KEY} 1\n")
+            endforeach()
+
+            set(WRAPPER_FILE "${VARIANTS_DIR}/${SHADER_NAME}_variant${MASK}.sc")
+            set(WRAPPER_SOURCE "${DEFINES}${SHADER_SOURCE}")
+            set(OLD_WRAPPER_SOURCE "")
+            if(EXISTS "${WRAPPER_FILE}")
+                file(READ "${WRAPPER_FILE}" OLD_WRAPPER_SOURCE)
+            endif()
+            # Only written when changed so the variants aren't compiled again on every configure
+            if(NOT "${OLD_WRAPPER_SOURCE}" STREQUAL "${WRAPPER_SOURCE}")
+                file(WRITE "${WRAPPER_FILE}" "${WRAPPER_SOURCE}")
+            endif()
+            list(APPEND WRAPPERS "${WRAPPER_FILE}")
+        endforeach()
+    endif()
+
+    list(JOIN KEYS " " KEYS_STRING)
+    set("${WRAPPERS_OUT_VAR}" ${WRAPPERS} PARENT_SCOPE)
+    set("${DECLARATION_OUT_VAR}" "    big2::ShaderVariantDeclaration{\"${SHADER_NAME}\", \"${SHADER_FILE}\", \"${KEYS_STRING}\"},\n" PARENT_SCOPE)
+endfunction()
+
 function(add_shaders_directory SHADERS_DIR TARGET_OUT_VAR)
     get_filename_component(SHADERS_DIR "${SHADERS_DIR}" ABSOLUTE)
     get_filename_component(NAMESPACE "${CMAKE_CURRENT_SOURCE_DIR}" NAME_WE)
@@ -35,6 +110,20 @@ function(add_shaders_directory SHADERS_DIR TARGET_OUT_VAR)
 
     file(MAKE_DIRECTORY "${SHADERS_OUT_DIR}")
 
+    set(VARIANTS_DIR "${CMAKE_CURRENT_BINARY_DIR}/shader_variants/${NAMESPACE}")
+    file(MAKE_DIRECTORY "${VARIANTS_DIR}")
+
+    set(VARIANT_DECLARATIONS "")
+    foreach(SHADER_TYPE IN ITEMS VERTEX FRAGMENT)
+        foreach(SHADER_FILE IN LISTS ${SHADER_TYPE}_SHADER_FILES)
+            add_shader_variants("${SHADER_FILE}" "${VARIANTS_DIR}" VARIANT_FILES VARIANT_DECLARATION)
+            list(APPEND ${SHADER_TYPE}_VARIANT_FILES ${VARIANT_FILES})
+            string(APPEND VARIANT_DECLARATIONS "${VARIANT_DECLARATION}")
+        endforeach()
+    endforeach()
+    list(APPEND VERTEX_SHADER_FILES ${VERTEX_VARIANT_FILES})
+    list(APPEND FRAGMENT_SHADER_FILES ${FRAGMENT_VARIANT_FILES})
+
     bgfx_compile_shaders(
             TYPE VERTEX
             SHADERS ${VERTEX_SHADER_FILES}
@@ -74,6 +163,20 @@ function(add_shaders_directory SHADERS_DIR TARGET_OUT_VAR)
     file(WRITE "${SHADERS_OUT_DIR}/all.h" "${INCLUDE_ALL_HEADER}")
     list(APPEND OUTPUT_FILES "${SHADERS_OUT_DIR}/all.h")
 
+    # Include after all.h and big2/bgfx/embedded_shader.h, then register both tables
+    string(MAKE_C_IDENTIFIER "${NAMESPACE}" NAMESPACE_IDENTIFIER)
+    set(VARIANTS_HEADER "#pragma once\n#include <big2/bgfx/bgfx_program_registry.h>\n\n")
+    string(APPEND VARIANTS_HEADER "static const bgfx::EmbeddedShader kEmbeddedShaderVariants_${NAMESPACE_IDENTIFIER}[] =\n{\n")
+    foreach(VARIANT_FILE IN LISTS VERTEX_VARIANT_FILES FRAGMENT_VARIANT_FILES)
+        get_filename_component(VARIANT_NAME "${VARIANT_FILE}" NAME_WE)
+        string(APPEND VARIANTS_HEADER "    BGFX_EMBEDDED_SHADER(${VARIANT_NAME}),\n")
+    endforeach()
+    string(APPEND VARIANTS_HEADER "    BGFX_EMBEDDED_SHADER_END()\n};\n\n")
+    string(APPEND VARIANTS_HEADER "static const big2::ShaderVariantDeclaration kShaderVariants_${NAMESPACE_IDENTIFIER}[] =\n{\n")
+    string(APPEND VARIANTS_HEADER "${VARIANT_DECLARATIONS}    big2::ShaderVariantDeclaration{nullptr, nullptr, nullptr},\n};\n")
+    file(WRITE "${SHADERS_OUT_DIR}/variants.h" "${VARIANTS_HEADER}")
+    list(APPEND OUTPUT_FILES "${SHADERS_OUT_DIR}/variants.h")
+
     string(MD5 DIR_HASH "${SHADERS_DIR}")
     set(TARGET_NAME "Shaders_${DIR_HASH}")
     add_custom_target("${DIR_HASH}" ALL
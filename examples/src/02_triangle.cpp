@@ -24,6 +24,10 @@ struct NormalColorVertex {
   uint32_t color;
 };
 
+BIG2_VERTEX_LAYOUT(NormalColorVertex,
+                   BIG2_VERTEX_ATTRIBUTE(NormalColorVertex, position, bgfx::Attrib::Position, 2, bgfx::AttribType::Float, false),
+                   BIG2_VERTEX_ATTRIBUTE(NormalColorVertex, color, bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true));
+
 int main(std::int32_t, gsl::zstring[]) {
   glfwSetErrorCallback(big2::GlfwErrorCallback);
   big2::Validate(glfwInit() == GLFW_TRUE, "GLFW couldn't be initialized!");
@@ -65,13 +69,7 @@ int main(std::int32_t, gsl::zstring[]) {
           0, 1, 2,
       };
 
-  bgfx::VertexLayout color_vertex_layout;
-  color_vertex_layout.begin()
-                     .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
-                     .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
-                     .end();
-
-  bgfx::VertexBufferHandle vertex_buffer = bgfx::createVertexBuffer(bgfx::makeRef(kTriangleVertices, sizeof(kTriangleVertices)), color_vertex_layout);
+  bgfx::VertexBufferHandle vertex_buffer = bgfx::createVertexBuffer(bgfx::makeRef(kTriangleVertices, sizeof(kTriangleVertices)), big2::GetVertexLayout<NormalColorVertex>());
   bgfx::IndexBufferHandle index_buffer = bgfx::createIndexBuffer(bgfx::makeRef(kTriangleIndices, sizeof(kTriangleIndices)));
 
   gsl::final_action destroy_buffers([&vertex_buffer, &index_buffer]() {
@@ -79,14 +77,9 @@ int main(std::int32_t, gsl::zstring[]) {
     bgfx::destroy(vertex_buffer);
   });
 
-  bgfx::RendererType::Enum renderer_type = bgfx::getRendererType();
-  bgfx::ProgramHandle program = bgfx::createProgram(
-      bgfx::createEmbeddedShader(kEmbeddedShaders, renderer_type, "vs_basic"),
-      bgfx::createEmbeddedShader(kEmbeddedShaders, renderer_type, "fs_basic"),
-      true
-  );
-
-  gsl::final_action destroy_program([&program]() { bgfx::destroy(program); });
+  // The program is created on its first use and destroyed with the last reference to it
+  big2::RegisterEmbeddedShaders(kEmbeddedShaders);
+  big2::ProgramReference program = big2::GetProgram("vs_basic", "fs_basic");
 
   while (!glfwWindowShouldClose(window)) {
     glfwPollEvents();
@@ -103,16 +96,11 @@ int main(std::int32_t, gsl::zstring[]) {
     // Ensure the view is redrawn even if no graphic commands are called
     bgfx::touch(main_view_id);
 
-    bgfx::setState(
-        BGFX_STATE_WRITE_R
-            | BGFX_STATE_WRITE_G
-            | BGFX_STATE_WRITE_B
-            | BGFX_STATE_WRITE_A
-    );
+    bgfx::setState(big2::RenderState().WithColorWrite());
 
     bgfx::setVertexBuffer(0, vertex_buffer);
     bgfx::setIndexBuffer(index_buffer);
-    bgfx::submit(main_view_id, program);
+    bgfx::submit(main_view_id, program.Get());
 
     // End the frame
     bgfx::frame();
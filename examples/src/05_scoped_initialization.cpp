@@ -54,7 +54,7 @@ int main(std::int32_t, gsl::zstring[]) {
     }
 #endif // BIG2_IMGUI_ENABLED
 
-    bgfx::frame();
+    big2::Frame();
   }
 
   return 0;
@@ -31,6 +31,10 @@ struct NormalColorVertex {
   uint32_t color;
 };
 
+BIG2_VERTEX_LAYOUT(NormalColorVertex,
+                   BIG2_VERTEX_ATTRIBUTE(NormalColorVertex, position, bgfx::Attrib::Position, 2, bgfx::AttribType::Float, false),
+                   BIG2_VERTEX_ATTRIBUTE(NormalColorVertex, color, bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true));
+
 int main(std::int32_t, gsl::zstring[]) {
   big2::GlfwInitializationScoped _glfw;
   big2::BgfxInitializationScoped _bgfx;
@@ -72,13 +76,7 @@ int main(std::int32_t, gsl::zstring[]) {
           0, 1, 2,
       };
 
-  bgfx::VertexLayout color_vertex_layout;
-  color_vertex_layout.begin()
-      .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
-      .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
-      .end();
-
-  bgfx::VertexBufferHandle vertex_buffer = bgfx::createVertexBuffer(bgfx::makeRef(kTriangleVertices, sizeof(kTriangleVertices)), color_vertex_layout);
+  bgfx::VertexBufferHandle vertex_buffer = bgfx::createVertexBuffer(bgfx::makeRef(kTriangleVertices, sizeof(kTriangleVertices)), big2::GetVertexLayout<NormalColorVertex>());
   bgfx::IndexBufferHandle index_buffer = bgfx::createIndexBuffer(bgfx::makeRef(kTriangleIndices, sizeof(kTriangleIndices)));
 
   gsl::final_action destroy_buffers([&vertex_buffer, &index_buffer]() {
@@ -114,18 +112,13 @@ int main(std::int32_t, gsl::zstring[]) {
     }
 #endif // BIG2_IMGUI_ENABLED
 
-    bgfx::setState(
-        BGFX_STATE_WRITE_R
-            | BGFX_STATE_WRITE_G
-            | BGFX_STATE_WRITE_B
-            | BGFX_STATE_WRITE_A
-    );
+    bgfx::setState(big2::RenderState().WithColorWrite());
 
     bgfx::setVertexBuffer(0, vertex_buffer);
     bgfx::setIndexBuffer(index_buffer);
     bgfx::submit(window.GetView(), program);
 
-    bgfx::frame();
+    big2::Frame();
   }
 
   return 0;
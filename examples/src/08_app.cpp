@@ -28,6 +28,10 @@ struct NormalColorVertex {
   uint32_t color;
 };
 
+BIG2_VERTEX_LAYOUT(NormalColorVertex,
+                   BIG2_VERTEX_ATTRIBUTE(NormalColorVertex, position, bgfx::Attrib::Position, 2, bgfx::AttribType::Float, false),
+                   BIG2_VERTEX_ATTRIBUTE(NormalColorVertex, color, bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true));
+
 NormalColorVertex kTriangleVertices[] =
 {
   {{-0.5f, -0.5f}, 0x339933FF},
@@ -47,16 +51,11 @@ class TriangleRenderAppExtension final : public big2::AppExtensionBase {
     }
     void OnRender(big2::Window &window) override {
       AppExtensionBase::OnRender(window);
-      bgfx::setState(
-        BGFX_STATE_WRITE_R
-        | BGFX_STATE_WRITE_G
-        | BGFX_STATE_WRITE_B
-        | BGFX_STATE_WRITE_A
-      );
+      bgfx::setState(big2::RenderState().WithColorWrite());
 
       bgfx::setVertexBuffer(0, vertex_buffer_);
       bgfx::setIndexBuffer(index_buffer_);
-      bgfx::submit(window.GetView(), program_);
+      bgfx::submit(window.GetView(), program_.Get());
 
 #if BIG2_IMGUI_ENABLED
       BIG2_SCOPE_VAR(big2::ImGuiFrameScoped) {
@@ -70,34 +69,24 @@ class TriangleRenderAppExtension final : public big2::AppExtensionBase {
     void OnInitialize() override {
       AppExtensionBase::OnInitialize();
 
-      bgfx::VertexLayout color_vertex_layout;
-      color_vertex_layout.begin()
-          .add(bgfx::Attrib::Position, 2, bgfx::AttribType::Float)
-          .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
-          .end();
-
-      vertex_buffer_ = bgfx::createVertexBuffer(bgfx::makeRef(kTriangleVertices, sizeof(kTriangleVertices)), color_vertex_layout);
-      index_buffer_ = bgfx::createIndexBuffer(bgfx::makeRef(kTriangleIndices, sizeof(kTriangleIndices)));
-
-      bgfx::RendererType::Enum renderer_type = bgfx::getRendererType();
-      program_ = bgfx::createProgram(
-        bgfx::createEmbeddedShader(kEmbeddedShaders, renderer_type, "vs_basic"),
-        bgfx::createEmbeddedShader(kEmbeddedShaders, renderer_type, "fs_basic"),
-        true
-      );
+      vertex_buffer_ = big2::CreateVertexBuffer(bgfx::makeRef(kTriangleVertices, sizeof(kTriangleVertices)), big2::GetVertexLayout<NormalColorVertex>());
+      index_buffer_ = big2::CreateIndexBuffer(bgfx::makeRef(kTriangleIndices, sizeof(kTriangleIndices)));
+
+      big2::RegisterEmbeddedShaders(kEmbeddedShaders);
+      program_ = big2::GetProgram("vs_basic", "fs_basic");
     }
 
     void OnTerminate() override {
       AppExtensionBase::OnTerminate();
       vertex_buffer_.Destroy();
       index_buffer_.Destroy();
-      program_.Destroy();
+      program_.Reset();
     }
 
   private:
     big2::VertexBufferScopedHandle vertex_buffer_;
     big2::IndexBufferScopedHandle index_buffer_;
-    big2::ProgramScopedHandle program_;
+    big2::ProgramReference program_;
 };
 
 int main(std::int32_t, gsl::zstring []) {